@@ -0,0 +1,310 @@
+/**
+  * Microbenchmarks of pipeline primitives. Each primitive runs over synthetic images of
+  * given size and blob density and over images from data directory. Result of each
+  * benchmark is median time of samples divided by number of image pixels, so numbers
+  * can be compared between releases.
+  *
+  * Usage: LegoDetector_bench <'--filter TEXT' - optional: run only benchmarks with TEXT in name>
+  * <'--samples N' - optional: number of samples, default 9> <'--threads N' - optional: number
+  * of threads, default 1> <'--data DIR' - optional: directory with images>
+  */
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+// lego
+#include "../src/utils.hpp"
+#include "../src/color_cvt.hpp"
+#include "../src/segmentation.hpp"
+#include "../src/moments.hpp"
+#include "../src/morphology.hpp"
+
+// std
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+
+// minimal time of one sample, fast primitives are repeated until it is reached
+const double MIN_SAMPLE_SECONDS = 0.02;
+const int DEFAULT_SAMPLES = 9;
+
+// blob color that is chosen by FILTER_GIMP: H ~ 37, S ~ 86, V ~ 82 in GIMP scale
+const cv::Vec3b BLOB_COLOR = cv::Vec3b(30, 140, 210);
+
+/**
+ * @brief The BenchInput struct - image and results of earlier stages used as input of later ones.
+ */
+struct BenchInput{
+    std::string name;
+    cv::Mat bgr;
+    cv::Mat hsv;
+    PackedPixelsMap pixels;
+    PackedPixelsMap neighbourPixels;
+    cv::Mat mask;
+    std::vector<Segment> segments;
+
+    size_t pixelsNumber() const {
+        return bgr.total();
+    }
+};
+
+/**
+ * @brief syntheticImage Create noisy gray image with yellow disks that cover given part of image.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param density Part of image covered by disks, from 0 to 1.
+ * @param seed Seed of random generator, the same seed gives the same image.
+ * @return BGR image.
+ */
+cv::Mat syntheticImage(int rows, int cols, double density, unsigned int seed){
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> noise(0, 30);
+
+    cv::Mat img(rows, cols, CV_8UC3);
+    for (int i = 0; i < rows; ++i){
+        for (int j = 0; j < cols; ++j){
+            uint8_t gray = static_cast<uint8_t>(90 + noise(generator));
+            img.at<cv::Vec3b>(i, j) = cv::Vec3b(gray, gray, gray);
+        }
+    }
+
+    std::uniform_int_distribution<int> radiusDistribution(8, 40);
+    std::uniform_int_distribution<int> rowDistribution(0, rows - 1);
+    std::uniform_int_distribution<int> colDistribution(0, cols - 1);
+    const size_t target = static_cast<size_t>(density * rows * cols);
+    size_t covered = 0;
+
+    while (covered < target){
+        int radius = radiusDistribution(generator);
+        int ci = rowDistribution(generator), cj = colDistribution(generator);
+        for (int i = std::max(0, ci - radius); i <= std::min(rows - 1, ci + radius); ++i){
+            for (int j = std::max(0, cj - radius); j <= std::min(cols - 1, cj + radius); ++j){
+                cv::Vec3b& pixel = img.at<cv::Vec3b>(i, j);
+                if ((i - ci) * (i - ci) + (j - cj) * (j - cj) <= radius * radius && pixel != BLOB_COLOR){
+                    pixel = BLOB_COLOR;
+                    ++covered;
+                }
+            }
+        }
+    }
+
+    return img;
+}
+
+/**
+ * @brief makeInput Prepare image and results of earlier stages.
+ */
+BenchInput makeInput(const std::string& name, const cv::Mat& bgr){
+    BenchInput input;
+    input.name = name;
+    input.bgr = bgr;
+    input.hsv = cvtImgColorsToGIMPHSV(bgr);
+    input.pixels = pickPixels(input.hsv, FILTER_GIMP);
+    input.segments = findSegments(input.pixels);
+    input.neighbourPixels = neighbourAwarePixelPicker(bgr, gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH,
+                                                      DEFUALT_PIX_CHOOSE_HEIGHT, DEFUALT_PIX_CHOOSE_PERCENT);
+    input.mask = cv::Mat(bgr.rows, bgr.cols, CV_8UC1);
+    for (int i = 0; i < bgr.rows; ++i){
+        for (int j = 0; j < bgr.cols; ++j){
+            input.mask.at<uint8_t>(i, j) = input.pixels.get(i, j) ? 1 : 0;
+        }
+    }
+    return input;
+}
+
+/**
+ * @brief measure Run operation in samples and return median time per pixel.
+ * @param op Operation, it returns value that depends on result, so it can't be skipped.
+ * @param pixels Number of image pixels.
+ * @param samples Number of samples.
+ * @return Nanoseconds per pixel.
+ */
+double measure(const std::function<size_t()>& op, size_t pixels, int samples){
+    using Clock = std::chrono::steady_clock;
+    static volatile size_t sink = 0;
+
+    // warm up and number of repetitions in sample
+    Clock::time_point start = Clock::now();
+    sink += op();
+    double once = std::chrono::duration<double>(Clock::now() - start).count();
+    int repetitions = std::max(1, static_cast<int>(MIN_SAMPLE_SECONDS / std::max(once, 1e-9)));
+
+    std::vector<double> times;
+    for (int s = 0; s < samples; ++s){
+        start = Clock::now();
+        for (int r = 0; r < repetitions; ++r){
+            sink += op();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        times.emplace_back(seconds * 1e9 / repetitions / static_cast<double>(std::max<size_t>(pixels, 1)));
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+/**
+ * @brief The Benchmark struct - named operation on prepared input.
+ */
+struct Benchmark{
+    std::string name;
+    std::function<size_t(const BenchInput&)> op;
+};
+
+std::vector<Benchmark> benchmarks(){
+    return {
+        {"rankFilter", [](const BenchInput& in){
+            return rankFilter(in.bgr, DEFUALT_RANK_FILTER_WIDTH, DEFUALT_RANK_FILTER_HEIGHT, DEFAULT_RANK_FILTER_RANK).total();
+        }},
+        {"cvtImgColorsToGIMPHSV", [](const BenchInput& in){
+            return cvtImgColorsToGIMPHSV(in.bgr).total();
+        }},
+        {"pickPixels", [](const BenchInput& in){
+            return pickPixels(in.hsv, FILTER_GIMP).count();
+        }},
+        {"pickPixels_lut", [](const BenchInput& in){
+            return pickPixels(in.bgr, gimpFilterLUT()).count();
+        }},
+        {"neighbourAwarePixelPicker", [](const BenchInput& in){
+            return neighbourAwarePixelPicker(in.hsv, FILTER_GIMP, DEFUALT_PIX_CHOOSE_WIDTH,
+                                             DEFUALT_PIX_CHOOSE_HEIGHT, DEFUALT_PIX_CHOOSE_PERCENT).count();
+        }},
+        {"neighbourAwarePixelPicker_lut", [](const BenchInput& in){
+            return neighbourAwarePixelPicker(in.bgr, gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH,
+                                             DEFUALT_PIX_CHOOSE_HEIGHT, DEFUALT_PIX_CHOOSE_PERCENT).count();
+        }},
+        {"closing", [](const BenchInput& in){
+            return closing(in.pixels, 3, 3).count();
+        }},
+        {"opening", [](const BenchInput& in){
+            return opening(in.pixels, 3, 3).count();
+        }},
+        {"dilation", [](const BenchInput& in){
+            return dilation(in.pixels, 3, 3).count();
+        }},
+        {"erosion", [](const BenchInput& in){
+            return erosion(in.pixels, 3, 3).count();
+        }},
+        {"dilation_31", [](const BenchInput& in){
+            return dilation(in.pixels, 31, 31).count();
+        }},
+        {"dilation_101", [](const BenchInput& in){
+            return dilation(in.pixels, 101, 101).count();
+        }},
+        {"dilateMask_31", [](const BenchInput& in){
+            return dilateMask(in.mask, 31, 31).total();
+        }},
+        {"findSegments", [](const BenchInput& in){
+            return findSegments(in.pixels).size();
+        }},
+        {"findSegments_floodfill", [](const BenchInput& in){
+            return findSegments(in.neighbourPixels, LabellingAlgorithm::FLOOD_FILL).size();
+        }},
+        {"findSegments_pixels", [](const BenchInput& in){
+            return findSegments(in.neighbourPixels, LabellingAlgorithm::PIXELS).size();
+        }},
+        {"findSegments_blocks", [](const BenchInput& in){
+            return findSegments(in.neighbourPixels, LabellingAlgorithm::BLOCKS).size();
+        }},
+        {"labelComponents", [](const BenchInput& in){
+            return static_cast<size_t>(labelComponents(in.neighbourPixels).count);
+        }},
+        {"labelComponentsBlocks", [](const BenchInput& in){
+            return static_cast<size_t>(labelComponentsBlocks(in.neighbourPixels).count);
+        }},
+        {"labelComponents_8", [](const BenchInput& in){
+            return static_cast<size_t>(labelComponents<8>(in.neighbourPixels).count);
+        }},
+        {"labelComponentsBlocks_8", [](const BenchInput& in){
+            return static_cast<size_t>(labelComponentsBlocks<8>(in.neighbourPixels).count);
+        }},
+        {"findSegmentStats", [](const BenchInput& in){
+            return findSegmentStats(in.pixels).size();
+        }},
+        {"findSegmentStats_8", [](const BenchInput& in){
+            return findSegmentStats<8>(in.pixels).size();
+        }},
+        {"getMoments", [](const BenchInput& in){
+            size_t result = 0;
+            for (auto& seg : in.segments){
+                result += getMoments(seg).size();
+            }
+            return result;
+        }},
+        {"isValidSegment", [](const BenchInput& in){
+            size_t result = 0;
+            for (auto& seg : in.segments){
+                result += isValidSegment(seg);
+            }
+            return result;
+        }},
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::string dataDir = LEGO_DATA_DIR;
+    int samples = DEFAULT_SAMPLES;
+    unsigned int threads = 1;
+
+    for (int i = 1; i < argc; ++i){
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) > 0){
+            samples = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) >= 0){
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--data") == 0 && i + 1 < argc){
+            dataDir = std::string(argv[++i]) + "/";
+        } else {
+            std::cout<<"Unknown argument: "<<argv[i]<<"\n";
+            return 0;
+        }
+    }
+    setThreadsNumber(threads);
+
+    // lookup table is compiled once, outside of measurements
+    gimpFilterLUT();
+
+    // synthetic inputs - sizes and part of image covered by blobs
+    std::vector<BenchInput> inputs;
+    for (auto size : std::vector<std::pair<int, int>>({{480, 640}, {1080, 1920}})){
+        for (double density : {0.01, 0.1, 0.3}){
+            std::ostringstream name;
+            name << "synthetic_" << size.second << "x" << size.first << "_d" << density;
+            inputs.emplace_back(makeInput(name.str(), syntheticImage(size.first, size.second, density, 7)));
+        }
+    }
+    for (auto& name : TEST_FILES_NAMES){
+        cv::Mat img = cv::imread(dataDir + name);
+        if (img.empty()){
+            std::cout<<"Can't read image: "<<dataDir + name<<"\n";
+            continue;
+        }
+        inputs.emplace_back(makeInput(name, img));
+    }
+
+    std::cout<<"benchmark;input;pixels;ns_per_pixel\n";
+    std::cout<<std::fixed<<std::setprecision(3);
+    for (auto& bench : benchmarks()){
+        for (auto& input : inputs){
+            std::string name = bench.name + "/" + input.name;
+            if (!filter.empty() && name.find(filter) == std::string::npos){
+                continue;
+            }
+            double ns = measure([&bench, &input](){ return bench.op(input); }, input.pixelsNumber(), samples);
+            std::cout<<bench.name<<";"<<input.name<<";"<<input.pixelsNumber()<<";"<<ns<<std::endl;
+        }
+    }
+
+    return 0;
+}
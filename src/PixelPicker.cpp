@@ -1,4 +1,9 @@
 #include "PixelPicker.hpp"
+#include "simd.hpp"
+
+// std
+#include<algorithm>
+#include<stdexcept>
 
 
 // PixelPicker
@@ -6,6 +11,15 @@
 PixelPicker::~PixelPicker()
 {}
 
+void PixelPicker::classifyRow(const float* hsv, size_t n, uint64_t* outBits) const {
+    std::fill(outBits, outBits + (n + 63) / 64, 0);
+    for (size_t j = 0; j < n; ++j, hsv += 3){
+        if (isCorrectPixel(hsv[0], hsv[1], hsv[2])){
+            outBits[j / 64] |= uint64_t(1) << (j % 64);
+        }
+    }
+}
+
 // HSVPixelPicker
 
 HSVPixelPicker::HSVPixelPicker(float minH, float maxH, float minS, float maxS, float minV, float maxV)
@@ -24,5 +38,114 @@ bool HSVPixelPicker::isCorrectPixel(float h, float s, float v) const {
     return true;
 }
 
+#ifdef LEGO_SIMD
+
+/**
+ * @brief classifyRowAVX2 Check 8 colors in each step, channels are gathered from interleaved
+ * row. Comparisons are ordered, so NaN is not valid - the same as in isCorrectPixel.
+ * @return First color that was not checked, it is multiple of 8.
+ */
+__attribute__((target("avx2")))
+static size_t classifyRowAVX2(const float* hsv, size_t n, uint64_t* outBits, const float* ranges){
+    const __m256i index = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256 minValues[3], maxValues[3];
+    for (int c = 0; c < 3; ++c){
+        minValues[c] = _mm256_set1_ps(ranges[2 * c]);
+        maxValues[c] = _mm256_set1_ps(ranges[2 * c + 1]);
+    }
+
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8){
+        __m256 valid = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int c = 0; c < 3; ++c){
+            __m256 channel = _mm256_i32gather_ps(hsv + 3 * j + c, index, 4);
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(channel, minValues[c], _CMP_GE_OQ));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(channel, maxValues[c], _CMP_LE_OQ));
+        }
+        uint64_t bits = static_cast<uint64_t>(_mm256_movemask_ps(valid));
+        outBits[j / 64] |= bits << (j % 64);
+    }
+
+    return j;
+}
+
+#endif // LEGO_SIMD
+
+void HSVPixelPicker::classifyRow(const float* hsv, size_t n, uint64_t* outBits) const {
+    std::fill(outBits, outBits + (n + 63) / 64, 0);
+
+    size_t j = 0;
+#ifdef LEGO_SIMD
+    if (detectSimdLevel() == SimdLevel::AVX2){
+        const float ranges[6] = {minH, maxH, minS, maxS, minV, maxV};
+        j = classifyRowAVX2(hsv, n, outBits, ranges);
+    }
+#endif
+
+    for (; j < n; ++j){
+        const float* color = hsv + 3 * j;
+        if (HSVPixelPicker::isCorrectPixel(color[0], color[1], color[2])){
+            outBits[j / 64] |= uint64_t(1) << (j % 64);
+        }
+    }
+}
 
+// MultiClassPixelPicker
 
+MultiClassPixelPicker::MultiClassPixelPicker(const std::vector<HSVPixelPicker>& classes)
+    :classes(classes)
+{
+    if (classes.empty() || classes.size() > MAX_CLASSES){
+        throw std::runtime_error("Wrong number of classes!");
+    }
+}
+
+size_t MultiClassPixelPicker::classesNumber() const {
+    return classes.size();
+}
+
+uint16_t MultiClassPixelPicker::classMask(float h, float s, float v) const {
+    uint16_t mask = 0;
+    for (size_t c = 0; c < classes.size(); ++c){
+        if (classes[c].isCorrectPixel(h, s, v)){
+            mask |= static_cast<uint16_t>(1u << c);
+        }
+    }
+    return mask;
+}
+
+bool MultiClassPixelPicker::isCorrectPixel(float h, float s, float v) const {
+    return classMask(h, s, v) != 0;
+}
+
+void MultiClassPixelPicker::classifyRow(const float* hsv, size_t n, uint64_t* outBits) const {
+    // colors are checked by one word, so they stay in cache for all classes and no buffer is needed
+    for (size_t begin = 0; begin < n; begin += 64, hsv += 3 * 64){
+        const size_t count = std::min<size_t>(64, n - begin);
+        uint64_t any = 0;
+        for (auto& picker : classes){
+            uint64_t classBits;
+            picker.classifyRow(hsv, count, &classBits);
+            any |= classBits;
+        }
+        outBits[begin / 64] = any;
+    }
+}
+
+void MultiClassPixelPicker::classifyRowClasses(const float* hsv, size_t n, uint16_t* outMasks, uint64_t* classBits) const {
+    const size_t words = (n + 63) / 64;
+
+    std::fill(outMasks, outMasks + n, 0);
+    for (size_t c = 0; c < classes.size(); ++c){
+        classes[c].classifyRow(hsv, n, classBits);
+        for (size_t w = 0; w < words; ++w){
+            // only chosen colors are visited
+            uint64_t word = classBits[w];
+            while (word != 0){
+                size_t j = w * 64 + __builtin_ctzll(word);
+                word &= word - 1;
+                outMasks[j] |= static_cast<uint16_t>(1u << c);
+            }
+        }
+    }
+}
@@ -6,6 +6,8 @@
 #define PIXELPICKER_HPP
 
 #include<cstdint>
+#include<cstddef>
+#include<vector>
 
 /**
  * @class PixelPicker
@@ -22,6 +24,14 @@ public:
      * @return True of color is valide, false otherwise.
      */
     virtual bool isCorrectPixel(float c1, float c2, float c3) const = 0;
+    /**
+     * @brief classifyRow Check row of colors, by default each color is checked by isCorrectPixel.
+     * @param hsv Row of n colors, 3 interleaved channels for each.
+     * @param n Number of colors.
+     * @param outBits Words for result, bit (j % 64) of word (j / 64) is set if color j is valid.
+     * All (n + 63) / 64 words are overwritten, bits after last color are 0.
+     */
+    virtual void classifyRow(const float* hsv, size_t n, uint64_t* outBits) const;
     /**
      * @brief ~PixelPicker - dummy virtual destructor.
      */
@@ -60,6 +70,78 @@ public:
      * @return True if color is in given ranges, false otherwise.
      */
     bool isCorrectPixel(float h, float s, float v) const;
+
+    /**
+     * @brief classifyRow Check row of colors by given in constructor ranges, 8 colors
+     * in each step when AVX2 is supported.
+     * @param hsv Row of n colors, 3 interleaved channels for each.
+     * @param n Number of colors.
+     * @param outBits Words for result, the same as in PixelPicker::classifyRow.
+     */
+    void classifyRow(const float* hsv, size_t n, uint64_t* outBits) const;
+};
+
+/**
+ * @class MultiClassPixelPicker
+ * @brief The MultiClassPixelPicker class - class appropirate to check colors by up to
+ * MAX_CLASSES HSV ranges at once. Each range is one class, for each color bit mask of
+ * classes which ranges contain it is given.
+ */
+class MultiClassPixelPicker : public PixelPicker{
+public:
+    static const size_t MAX_CLASSES = 16;
+
+private:
+    std::vector<HSVPixelPicker> classes;
+
+public:
+    /**
+     * @brief MultiClassPixelPicker construct picker with given classes.
+     * @param classes Ranges of classes, class ID is index in vector.
+     */
+    explicit MultiClassPixelPicker(const std::vector<HSVPixelPicker>& classes);
+
+    /**
+     * @brief classesNumber Number of classes.
+     */
+    size_t classesNumber() const;
+
+    /**
+     * @brief classMask Check color by ranges of all classes.
+     * @param h H(hue) value.
+     * @param s S(saturation) value.
+     * @param v V(value) value.
+     * @return Bit mask of classes, bit c is set if color is in ranges of class c.
+     */
+    uint16_t classMask(float h, float s, float v) const;
+
+    /**
+     * @brief isCorrectPixel Check if color belongs to any class.
+     * @param h H(hue) value.
+     * @param s S(saturation) value.
+     * @param v V(value) value.
+     * @return True if color is in ranges of any class, false otherwise.
+     */
+    bool isCorrectPixel(float h, float s, float v) const;
+
+    /**
+     * @brief classifyRow Check if colors of row belong to any class.
+     * @param hsv Row of n colors, 3 interleaved channels for each.
+     * @param n Number of colors.
+     * @param outBits Words for result, the same as in PixelPicker::classifyRow.
+     */
+    void classifyRow(const float* hsv, size_t n, uint64_t* outBits) const;
+
+    /**
+     * @brief classifyRowClasses Check row of colors by ranges of all classes, each class
+     * is checked by vectorized HSVPixelPicker::classifyRow.
+     * @param hsv Row of n colors, 3 interleaved channels for each.
+     * @param n Number of colors.
+     * @param outMasks Buffer for n class masks, the same as from classMask.
+     * @param classBits Buffer for (n + 63) / 64 words used by each class, given by caller
+     * so it can be reused by all rows.
+     */
+    void classifyRowClasses(const float* hsv, size_t n, uint16_t* outMasks, uint64_t* classBits) const;
 };
 
 
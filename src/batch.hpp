@@ -0,0 +1,332 @@
+/**
+  * Batch mode - many images are processed by one process. Calling thread passes indices of
+  * images through bounded queue to worker threads, each worker decodes, processes and writes
+  * its own image, so decoding runs in parallel and only images of workers are kept in memory.
+  * Errors of single images are saved in results and don't stop batch.
+  */
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// std
+#include <vector>
+#include <string>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <set>
+#include <cctype>
+
+// extensions of files taken from directory, compared without case
+const std::vector<std::string> IMAGE_EXTENSIONS = {".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff"};
+
+const size_t DEFAULT_BATCH_QUEUE_SIZE = 8;
+
+/**
+ * @class BoundedQueue
+ * @brief The BoundedQueue class - FIFO queue with limited size shared by threads. Push
+ * waits while queue is full, pop waits while queue is empty and not closed.
+ */
+template <typename T>
+class BoundedQueue{
+private:
+    std::queue<T> items;
+    size_t capacity;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)), closed(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief push Add item to queue, wait if queue is full.
+     * @param item Item to add.
+     * @return False if queue is closed, item is not added then.
+     */
+    bool push(T item){
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this](){ return closed || items.size() < capacity; });
+        if (closed){
+            return false;
+        }
+        items.push(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief pop Take first item from queue, wait if queue is empty.
+     * @param item Taken item.
+     * @return False if queue is closed and empty.
+     */
+    bool pop(T& item){
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this](){ return closed || !items.empty(); });
+        if (items.empty()){
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief close Close queue - items can't be added, but items already in queue can be taken.
+     */
+    void close(){
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    size_t size(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+};
+
+/**
+ * @brief fileName Get name of file without directory.
+ */
+inline std::string fileName(const std::string& path){
+    size_t pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+/**
+ * @brief isImageFile Check if file has one of IMAGE_EXTENSIONS.
+ */
+inline bool isImageFile(const std::string& path){
+    std::string name = fileName(path);
+    size_t pos = name.find_last_of('.');
+    if (pos == std::string::npos){
+        return false;
+    }
+    std::string extension = name.substr(pos);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    return std::find(IMAGE_EXTENSIONS.begin(), IMAGE_EXTENSIONS.end(), extension) != IMAGE_EXTENSIONS.end();
+}
+
+/**
+ * @brief readManifest Read list of images from manifest file - one path in line, empty lines
+ * and lines started with '#' are skipped. Relative paths are relative to manifest directory.
+ * @param manifest Path to manifest file.
+ * @return Paths of images in manifest order.
+ */
+inline std::vector<std::string> readManifest(const std::string& manifest){
+    std::ifstream file(manifest);
+    if (!file.is_open()){
+        throw std::runtime_error("Can't open manifest file: " + manifest);
+    }
+
+    std::string directory = manifest.substr(0, manifest.size() - fileName(manifest).size());
+    std::vector<std::string> files;
+    std::string line;
+    while (std::getline(file, line)){
+        // trim white characters, also '\r' from windows files
+        size_t first = line.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos || line[first] == '#'){
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+
+        bool absolute = line[0] == '/' || line[0] == '\\' || (line.size() > 1 && line[1] == ':');
+        files.emplace_back(absolute ? line : directory + line);
+    }
+
+    return files;
+}
+
+/**
+ * @brief collectInputFiles Get list of images for batch mode.
+ * @param input Directory (all images in it), glob pattern with '*' or '?' (all matching files)
+ * or manifest file (see readManifest).
+ * @return Paths of images, sorted for directory and pattern.
+ */
+inline std::vector<std::string> collectInputFiles(const std::string& input){
+    std::vector<std::string> files;
+
+    if (cv::utils::fs::isDirectory(input)){
+        std::vector<std::string> all;
+        cv::glob(input, all, false);
+        std::copy_if(all.begin(), all.end(), std::back_inserter(files), isImageFile);
+    } else if (input.find_first_of("*?") != std::string::npos){
+        cv::glob(input, files, false);
+    } else {
+        return readManifest(input);
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/**
+ * @brief outputFilePath Get path of result image in output directory - the same file name as input.
+ */
+inline std::string outputFilePath(const std::string& outputDir, const std::string& inputFile){
+    if (outputDir.empty()){
+        return fileName(inputFile);
+    }
+    char last = outputDir[outputDir.size() - 1];
+    return outputDir + ((last == '/' || last == '\\') ? "" : "/") + fileName(inputFile);
+}
+
+/**
+ * @brief outputFilePaths Get paths of result images of all files. Files from different directories
+ * can have the same name, so repeated names get suffix before extension: 'img.jpg', 'img_2.jpg', ...
+ * @param outputDir Output directory.
+ * @param files Paths of images.
+ * @return Unique paths of result images in order of files.
+ */
+inline std::vector<std::string> outputFilePaths(const std::string& outputDir, const std::vector<std::string>& files){
+    std::vector<std::string> result;
+    std::set<std::string> used;
+    for (auto& file : files){
+        std::string path = outputFilePath(outputDir, file);
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)){
+            dot = path.size();
+        }
+        std::string base = path.substr(0, dot), extension = path.substr(dot);
+        for (int copy = 2; used.count(path) != 0; ++copy){
+            path = base + "_" + std::to_string(copy) + extension;
+        }
+        used.insert(path);
+        result.emplace_back(path);
+    }
+    return result;
+}
+
+/**
+ * @brief The BatchResult struct - result of one image from batch.
+ */
+struct BatchResult{
+    std::string inputFile;
+    std::string outputFile;
+    bool success = false;
+    std::string error;
+};
+
+/**
+ * @brief The BatchOptions struct - options of batch mode.
+ * workers - number of threads that process images, 0 means number of hardware threads.
+ * queueSize - maximal number of images waiting for worker, they are not decoded yet.
+ * writeImages - if result images are written to output directory.
+ */
+struct BatchOptions{
+    unsigned int workers = 0;
+    size_t queueSize = DEFAULT_BATCH_QUEUE_SIZE;
+    bool writeImages = true;
+};
+
+/**
+ * @brief runBatch Process list of images. Calling thread puts indices of images to bounded queue,
+ * workers take them, read image, call process and optionally write result image to output directory.
+ * Errors of reading, processing and writing are saved in result of image, other images are processed.
+ * @param files Paths of images.
+ * @param outputDir Directory for result images, created if doesn't exist.
+ * @param process Function called with path and image, it can change image. It is called
+ * in parallel from worker threads.
+ * @param options Number of workers, queue size and if images are written.
+ * @param onResult Function called after each image, calls are not concurrent.
+ * @return Results in order of files.
+ */
+inline std::vector<BatchResult> runBatch(const std::vector<std::string>& files, const std::string& outputDir,
+                                         const std::function<void(const std::string&, cv::Mat&)>& process,
+                                         const BatchOptions& options = BatchOptions(),
+                                         const std::function<void(const BatchResult&)>& onResult = nullptr){
+    if (options.writeImages && !outputDir.empty() && !cv::utils::fs::isDirectory(outputDir) && !cv::utils::fs::createDirectories(outputDir)){
+        throw std::runtime_error("Can't create output directory: " + outputDir);
+    }
+
+    // output paths are unique, so workers never write the same file
+    std::vector<std::string> outputFiles = outputFilePaths(outputDir, files);
+    std::vector<BatchResult> results(files.size());
+    for (size_t i = 0; i < files.size(); ++i){
+        results[i].inputFile = files[i];
+        results[i].outputFile = options.writeImages ? outputFiles[i] : "";
+    }
+
+    // indices of images waiting for worker
+    BoundedQueue<size_t> queue(options.queueSize);
+    std::mutex resultMutex;
+
+    // each worker writes only results of its images
+    auto finish = [&](BatchResult& result, bool success, const std::string& error){
+        result.success = success;
+        result.error = error;
+        if (onResult){
+            std::lock_guard<std::mutex> lock(resultMutex);
+            onResult(result);
+        }
+    };
+
+    auto work = [&](){
+        size_t index;
+        while (queue.pop(index)){
+            BatchResult& result = results[index];
+            cv::Mat img;
+            try {
+                img = cv::imread(result.inputFile);
+            } catch (...) {
+                img = cv::Mat();
+            }
+            if (img.empty()){
+                finish(result, false, "Can't read image");
+                continue;
+            }
+            try {
+                process(result.inputFile, img);
+                if (options.writeImages && !cv::imwrite(result.outputFile, img)){
+                    finish(result, false, "Can't write image: " + result.outputFile);
+                    continue;
+                }
+            } catch (const std::exception& e) {
+                finish(result, false, e.what());
+                continue;
+            } catch (...) {
+                finish(result, false, "Unknown error");
+                continue;
+            }
+            finish(result, true, "");
+        }
+    };
+
+    unsigned int workersNumber = options.workers == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.workers;
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < workersNumber; ++i){
+        workers.emplace_back(work);
+    }
+
+    for (size_t i = 0; i < files.size(); ++i){
+        queue.push(i);
+    }
+    queue.close();
+
+    for (auto& w : workers){
+        w.join();
+    }
+
+    return results;
+}
+
+#endif // BATCH_HPP
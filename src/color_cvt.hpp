@@ -1,6 +1,6 @@
 /**
-  * Few functions to convert color scale to HSV.
-  * #TODO - code duplications!
+  * Few functions to convert color scale to HSV. Per pixel functions are reference,
+  * images are converted by row kernels or by cvtImgColors with compile time scale.
   */
 
 #ifndef COLOR_CVT_HPP
@@ -13,6 +13,14 @@
 #include <vector>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+// lego
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "profiler.hpp"
 
 // DEFINITIONS OF COLOR SCALES WHEN CONVERT TO HSV
 
@@ -32,6 +40,36 @@ const unsigned int VALUE_SCALE_GIMP = 100;
 const unsigned int SATURATION_SCALE_GIMP = 100;
 
 
+// compile time versions of scales above, used as template parameters
+struct OwnScale{
+    static constexpr unsigned int HUE_DIVISOR = HUE_SCALE;
+    static constexpr unsigned int SATURATION = SATURATION_SCALE;
+    static constexpr unsigned int VALUE = VALUE_SCALE;
+};
+
+struct OpenCVScale{
+    static constexpr unsigned int HUE_DIVISOR = HUE_SCALE_OPENCV;
+    static constexpr unsigned int SATURATION = SATURATION_SCALE_OPENCV;
+    static constexpr unsigned int VALUE = VALUE_SCALE_OPENCV;
+};
+
+// GIMP hue is multiplied by HUE_SCALE_GIMP, it is 1, so dividing gives the same values
+struct GIMPScale{
+    static_assert(HUE_SCALE_GIMP == 1, "GIMP hue scale is not 1!");
+    static constexpr unsigned int HUE_DIVISOR = 1;
+    static constexpr unsigned int SATURATION = SATURATION_SCALE_GIMP;
+    static constexpr unsigned int VALUE = VALUE_SCALE_GIMP;
+};
+
+/**
+ * @brief hsvScaleFitsByte Check if all values of scale fit in 8 bits.
+ */
+template <typename ScalePolicy>
+constexpr bool hsvScaleFitsByte(){
+    return 360 / ScalePolicy::HUE_DIVISOR <= 256 && ScalePolicy::SATURATION <= 255 && ScalePolicy::VALUE <= 255;
+}
+
+
 typedef std::vector<uint8_t> (*cvtColorFuntion)(uint8_t r, uint8_t g, uint8_t b);
 
 
@@ -41,9 +79,9 @@ typedef std::vector<uint8_t> (*cvtColorFuntion)(uint8_t r, uint8_t g, uint8_t b)
  * @param b Blue color value.
  * @param g Green color value.
  * @param r Red color value.
- * @return HSV color as a vector 0<H<360, 0<S<1, 0<V<1.
+ * @param hsv Array of 3 values for HSV color 0<H<360, 0<S<1, 0<V<1.
  */
-std::vector<double> cvtColorBGRToHSV(uint8_t b, uint8_t g, uint8_t r){
+inline void cvtColorBGRToHSV(uint8_t b, uint8_t g, uint8_t r, double* hsv){
     double r_ = r/static_cast<double>(std::numeric_limits<uint8_t>::max());
     double g_ = g/static_cast<double>(std::numeric_limits<uint8_t>::max());
     double b_ = b/static_cast<double>(std::numeric_limits<uint8_t>::max());
@@ -80,9 +118,65 @@ std::vector<double> cvtColorBGRToHSV(uint8_t b, uint8_t g, uint8_t r){
         hue+=360;
     }
 
-    return {hue, saturation, value};
+    hsv[0] = hue;
+    hsv[1] = saturation;
+    hsv[2] = value;
+}
+
+/**
+ * @details cvtColorBGRtoHSV Convert BGR color to HSV color - for details look:
+ * https://docs.opencv.org/2.4/modules/imgproc/doc/miscellaneous_transformations.html
+ * @param b Blue color value.
+ * @param g Green color value.
+ * @param r Red color value.
+ * @return HSV color as a vector 0<H<360, 0<S<1, 0<V<1.
+ */
+inline std::vector<double> cvtColorBGRToHSV(uint8_t b, uint8_t g, uint8_t r){
+    std::vector<double> hsv(3);
+    cvtColorBGRToHSV(b, g, r, hsv.data());
+    return hsv;
+}
+
+
+/**
+ * @brief scaleHSV Scale HSV color given by cvtColorBGRToHSV and save it as 8 bit values,
+ * values are truncated like in cvtColorBGRToHSVOwnScale. Value is counted from max channel
+ * with integer math - it gives the same values as double math for all 8 bit channels, hue
+ * and saturation stay in double, because integer division differs from truncated double
+ * result for some colors.
+ */
+template <typename ScalePolicy>
+inline void scaleHSV(const double* color, uint8_t maxChannel, uint8_t* hsv){
+    static_assert(hsvScaleFitsByte<ScalePolicy>(), "Scale doesn't fit in 8 bits!");
+    hsv[0] = static_cast<uint8_t>(color[0] / ScalePolicy::HUE_DIVISOR);
+    hsv[1] = static_cast<uint8_t>(color[1] * ScalePolicy::SATURATION);
+    hsv[2] = static_cast<uint8_t>(maxChannel * ScalePolicy::VALUE / std::numeric_limits<uint8_t>::max());
 }
 
+/**
+ * @brief scaleHSV Scale HSV color given by cvtColorBGRToHSV and save it as float values.
+ */
+template <typename ScalePolicy>
+inline void scaleHSV(const double* color, uint8_t maxChannel, float* hsv){
+    (void)maxChannel;
+    hsv[0] = static_cast<float>(color[0] / ScalePolicy::HUE_DIVISOR);
+    hsv[1] = static_cast<float>(color[1] * ScalePolicy::SATURATION);
+    hsv[2] = static_cast<float>(color[2] * ScalePolicy::VALUE);
+}
+
+/**
+ * @brief cvtColorBGRToHSVScaled Convert BGR color to HSV color in scale given by policy.
+ * @param b Blue color value.
+ * @param g Green color value.
+ * @param r Red color value.
+ * @param hsv Array of 3 values for HSV color.
+ */
+template <typename ScalePolicy, typename OutT>
+inline void cvtColorBGRToHSVScaled(uint8_t b, uint8_t g, uint8_t r, OutT* hsv){
+    double color[3];
+    cvtColorBGRToHSV(b, g, r, color);
+    scaleHSV<ScalePolicy>(color, std::max({b, g, r}), hsv);
+}
 
 /**
  * @details cvtColorBGRtoHSVOwnScale Convert BGR color to HSV color - for details look:
@@ -93,17 +187,10 @@ std::vector<double> cvtColorBGRToHSV(uint8_t b, uint8_t g, uint8_t r){
  * @param r Red color value.
  * @return HSV color as a vector, 0<H<180, 0<S<100, 0<V<100.
  */
-std::vector<uint8_t> cvtColorBGRToHSVOwnScale(uint8_t b, uint8_t g, uint8_t r){
-    // run convert value to HSV
-    auto color = cvtColorBGRToHSV(b, g, r);
-
-    // convert values to OpenCV scale
-    uint8_t hue = static_cast<uint8_t>(color[0]/HUE_SCALE);
-    uint8_t saturation = static_cast<uint8_t>(color[1]*SATURATION_SCALE);
-    uint8_t value = static_cast<uint8_t>((color[2]*VALUE_SCALE));
-
-
-    return {hue, saturation, value};
+inline std::vector<uint8_t> cvtColorBGRToHSVOwnScale(uint8_t b, uint8_t g, uint8_t r){
+    std::vector<uint8_t> hsv(3);
+    cvtColorBGRToHSVScaled<OwnScale>(b, g, r, hsv.data());
+    return hsv;
 }
 
 /**
@@ -115,23 +202,17 @@ std::vector<uint8_t> cvtColorBGRToHSVOwnScale(uint8_t b, uint8_t g, uint8_t r){
  * @param r Red color value.
  * @return HSV color as a vector, 0<H<180, 0<S<255, 0<V<255.
  */
-std::vector<uint8_t> cvtColorBGRToHSVOpenCVScale(uint8_t r, uint8_t g, uint8_t b){
-    // run convert value to HSV
-    auto color = cvtColorBGRToHSV(r, g, b);
-
-    // convert values to OpenCV scale
-    uint8_t hue = static_cast<uint8_t>(color[0]/HUE_SCALE_OPENCV);
-    uint8_t saturation = static_cast<uint8_t>(color[1]*SATURATION_SCALE_OPENCV);
-    uint8_t value = static_cast<uint8_t>((color[2]*VALUE_SCALE_OPENCV));
-
-    return {hue, saturation, value};
+inline std::vector<uint8_t> cvtColorBGRToHSVOpenCVScale(uint8_t b, uint8_t g, uint8_t r){
+    std::vector<uint8_t> hsv(3);
+    cvtColorBGRToHSVScaled<OpenCVScale>(b, g, r, hsv.data());
+    return hsv;
 }
 
 
-std::vector<uint8_t> cvtColorHSVToBGROpenCVScale(uint8_t h, uint8_t s, uint8_t v){
-    double h_ = h * static_cast<double>(HUE_SCALE_OPENCV);
-    double s_ = s / static_cast<double>(SATURATION_SCALE_OPENCV);
-    double v_ = v / static_cast<double>(VALUE_SCALE_OPENCV);
+inline std::vector<uint8_t> cvtColorHSVToBGROpenCVScale(uint8_t h, uint8_t s, uint8_t v){
+    double h_ = h * static_cast<double>(OpenCVScale::HUE_DIVISOR);
+    double s_ = s / static_cast<double>(OpenCVScale::SATURATION);
+    double v_ = v / static_cast<double>(OpenCVScale::VALUE);
 
     h_ = h_/60.0;
 
@@ -192,13 +273,293 @@ std::vector<uint8_t> cvtColorHSVToBGROpenCVScale(uint8_t h, uint8_t s, uint8_t v
     return {static_cast<uint8_t>(b),static_cast<uint8_t>(g), static_cast<uint8_t>(r) };
 }
 
+/**
+ * @brief The HSVScaleFactors struct - hue is divided and saturation and value are
+ * multiplied by factors of scale policy, loaded to registers by vector kernels.
+ */
+struct HSVScaleFactors{
+    double hueDivisor;
+    double saturationFactor;
+    double valueFactor;
+};
+
+/**
+ * @brief hsvScaleFactors Get factors of given scale.
+ */
+template <typename ScalePolicy>
+constexpr HSVScaleFactors hsvScaleFactors(){
+    return {static_cast<double>(ScalePolicy::HUE_DIVISOR), static_cast<double>(ScalePolicy::SATURATION),
+            static_cast<double>(ScalePolicy::VALUE)};
+}
+
+/**
+ * @brief The HSVRowOutput struct - caller buffers for converted row. For interleaved
+ * output channels point to h, s, v of first pixel and step is 3, for planar output each
+ * channel points to its own plane and step is 1.
+ */
+template <typename OutT>
+struct HSVRowOutput{
+    OutT* h;
+    OutT* s;
+    OutT* v;
+    int step;
+
+    void store(int j, OutT hue, OutT saturation, OutT value) const {
+        h[j * step] = hue;
+        s[j * step] = saturation;
+        v[j * step] = value;
+    }
+};
+
+/**
+ * @brief cvtRowBGRToHSVScalar Convert pixels [begin, n) of row by per pixel conversion.
+ */
+template <typename ScalePolicy, typename OutT>
+inline void cvtRowBGRToHSVScalar(const uint8_t* bgr, int begin, int n, const HSVRowOutput<OutT>& out){
+    for (int j = begin; j < n; ++j){
+        OutT color[3];
+        cvtColorBGRToHSVScaled<ScalePolicy>(bgr[3 * j], bgr[3 * j + 1], bgr[3 * j + 2], color);
+        out.store(j, color[0], color[1], color[2]);
+    }
+}
+
+#ifdef LEGO_SIMD
+
+// vector kernels repeat double precision operations of cvtColorBGRToHSV in the same order,
+// branches are replaced by blends, so results are the same as from reference
+
+__attribute__((target("avx2")))
+inline void storeHSVAVX2(const HSVRowOutput<float>& out, int j, __m256d h, __m256d s, __m256d v){
+    alignas(16) float hf[4], sf[4], vf[4];
+    _mm_store_ps(hf, _mm256_cvtpd_ps(h));
+    _mm_store_ps(sf, _mm256_cvtpd_ps(s));
+    _mm_store_ps(vf, _mm256_cvtpd_ps(v));
+    for (int l = 0; l < 4; ++l){
+        out.store(j + l, hf[l], sf[l], vf[l]);
+    }
+}
+
+__attribute__((target("avx2")))
+inline void storeHSVAVX2(const HSVRowOutput<uint8_t>& out, int j, __m256d h, __m256d s, __m256d v){
+    alignas(16) int32_t hi[4], si[4], vi[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(hi), _mm256_cvttpd_epi32(h));
+    _mm_store_si128(reinterpret_cast<__m128i*>(si), _mm256_cvttpd_epi32(s));
+    _mm_store_si128(reinterpret_cast<__m128i*>(vi), _mm256_cvttpd_epi32(v));
+    for (int l = 0; l < 4; ++l){
+        out.store(j + l, static_cast<uint8_t>(hi[l]), static_cast<uint8_t>(si[l]), static_cast<uint8_t>(vi[l]));
+    }
+}
+
+/**
+ * @brief cvtRowBGRToHSVAVX2 Convert row, 4 pixels in each step.
+ * @return First pixel that was not converted.
+ */
+template <typename OutT>
+__attribute__((target("avx2")))
+int cvtRowBGRToHSVAVX2(const uint8_t* bgr, int n, const HSVScaleFactors& f, const HSVRowOutput<OutT>& out){
+    const __m256d maxChannel = _mm256_set1_pd(static_cast<double>(std::numeric_limits<uint8_t>::max()));
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d c60 = _mm256_set1_pd(60.0), c120 = _mm256_set1_pd(120.0);
+    const __m256d c240 = _mm256_set1_pd(240.0), c360 = _mm256_set1_pd(360.0);
+    const __m256d hueDivisor = _mm256_set1_pd(f.hueDivisor);
+    const __m256d saturationFactor = _mm256_set1_pd(f.saturationFactor);
+    const __m256d valueFactor = _mm256_set1_pd(f.valueFactor);
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4){
+        const uint8_t* p = bgr + 3 * j;
+        __m256d b = _mm256_div_pd(_mm256_cvtepi32_pd(_mm_setr_epi32(p[0], p[3], p[6], p[9])), maxChannel);
+        __m256d g = _mm256_div_pd(_mm256_cvtepi32_pd(_mm_setr_epi32(p[1], p[4], p[7], p[10])), maxChannel);
+        __m256d r = _mm256_div_pd(_mm256_cvtepi32_pd(_mm_setr_epi32(p[2], p[5], p[8], p[11])), maxChannel);
+
+        __m256d max = _mm256_max_pd(_mm256_max_pd(r, g), b);
+        __m256d min = _mm256_min_pd(_mm256_min_pd(r, g), b);
+        __m256d delta = _mm256_sub_pd(max, min);
+
+        // hue
+        __m256d hueR = _mm256_div_pd(_mm256_mul_pd(c60, _mm256_sub_pd(g, b)), delta);
+        __m256d hueG = _mm256_add_pd(c120, _mm256_div_pd(_mm256_mul_pd(c60, _mm256_sub_pd(b, r)), delta));
+        __m256d hueB = _mm256_add_pd(c240, _mm256_div_pd(_mm256_mul_pd(c60, _mm256_sub_pd(r, g)), delta));
+        __m256d hue = _mm256_blendv_pd(hueB, hueG, _mm256_cmp_pd(max, g, _CMP_EQ_OQ));
+        hue = _mm256_blendv_pd(hue, hueR, _mm256_cmp_pd(max, r, _CMP_EQ_OQ));
+        hue = _mm256_blendv_pd(hue, zero, _mm256_cmp_pd(delta, zero, _CMP_EQ_OQ));
+        hue = _mm256_blendv_pd(hue, _mm256_add_pd(hue, c360), _mm256_cmp_pd(hue, zero, _CMP_LT_OQ));
+
+        // saturation
+        __m256d saturation = _mm256_blendv_pd(_mm256_div_pd(delta, max), zero, _mm256_cmp_pd(max, zero, _CMP_EQ_OQ));
+
+        storeHSVAVX2(out, j, _mm256_div_pd(hue, hueDivisor), _mm256_mul_pd(saturation, saturationFactor),
+                     _mm256_mul_pd(max, valueFactor));
+    }
+
+    return j;
+}
+
+__attribute__((target("sse4.1")))
+inline void storeHSVSSE41(const HSVRowOutput<float>& out, int j, __m128d h, __m128d s, __m128d v){
+    alignas(16) float hf[4], sf[4], vf[4];
+    _mm_store_ps(hf, _mm_cvtpd_ps(h));
+    _mm_store_ps(sf, _mm_cvtpd_ps(s));
+    _mm_store_ps(vf, _mm_cvtpd_ps(v));
+    for (int l = 0; l < 2; ++l){
+        out.store(j + l, hf[l], sf[l], vf[l]);
+    }
+}
+
+__attribute__((target("sse4.1")))
+inline void storeHSVSSE41(const HSVRowOutput<uint8_t>& out, int j, __m128d h, __m128d s, __m128d v){
+    alignas(16) int32_t hi[4], si[4], vi[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(hi), _mm_cvttpd_epi32(h));
+    _mm_store_si128(reinterpret_cast<__m128i*>(si), _mm_cvttpd_epi32(s));
+    _mm_store_si128(reinterpret_cast<__m128i*>(vi), _mm_cvttpd_epi32(v));
+    for (int l = 0; l < 2; ++l){
+        out.store(j + l, static_cast<uint8_t>(hi[l]), static_cast<uint8_t>(si[l]), static_cast<uint8_t>(vi[l]));
+    }
+}
+
+/**
+ * @brief cvtRowBGRToHSVSSE41 Convert row, 2 pixels in each step.
+ * @return First pixel that was not converted.
+ */
+template <typename OutT>
+__attribute__((target("sse4.1")))
+int cvtRowBGRToHSVSSE41(const uint8_t* bgr, int n, const HSVScaleFactors& f, const HSVRowOutput<OutT>& out){
+    const __m128d maxChannel = _mm_set1_pd(static_cast<double>(std::numeric_limits<uint8_t>::max()));
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d c60 = _mm_set1_pd(60.0), c120 = _mm_set1_pd(120.0);
+    const __m128d c240 = _mm_set1_pd(240.0), c360 = _mm_set1_pd(360.0);
+    const __m128d hueDivisor = _mm_set1_pd(f.hueDivisor);
+    const __m128d saturationFactor = _mm_set1_pd(f.saturationFactor);
+    const __m128d valueFactor = _mm_set1_pd(f.valueFactor);
+
+    int j = 0;
+    for (; j + 2 <= n; j += 2){
+        const uint8_t* p = bgr + 3 * j;
+        __m128d b = _mm_div_pd(_mm_cvtepi32_pd(_mm_setr_epi32(p[0], p[3], 0, 0)), maxChannel);
+        __m128d g = _mm_div_pd(_mm_cvtepi32_pd(_mm_setr_epi32(p[1], p[4], 0, 0)), maxChannel);
+        __m128d r = _mm_div_pd(_mm_cvtepi32_pd(_mm_setr_epi32(p[2], p[5], 0, 0)), maxChannel);
+
+        __m128d max = _mm_max_pd(_mm_max_pd(r, g), b);
+        __m128d min = _mm_min_pd(_mm_min_pd(r, g), b);
+        __m128d delta = _mm_sub_pd(max, min);
+
+        // hue
+        __m128d hueR = _mm_div_pd(_mm_mul_pd(c60, _mm_sub_pd(g, b)), delta);
+        __m128d hueG = _mm_add_pd(c120, _mm_div_pd(_mm_mul_pd(c60, _mm_sub_pd(b, r)), delta));
+        __m128d hueB = _mm_add_pd(c240, _mm_div_pd(_mm_mul_pd(c60, _mm_sub_pd(r, g)), delta));
+        __m128d hue = _mm_blendv_pd(hueB, hueG, _mm_cmpeq_pd(max, g));
+        hue = _mm_blendv_pd(hue, hueR, _mm_cmpeq_pd(max, r));
+        hue = _mm_blendv_pd(hue, zero, _mm_cmpeq_pd(delta, zero));
+        hue = _mm_blendv_pd(hue, _mm_add_pd(hue, c360), _mm_cmplt_pd(hue, zero));
+
+        // saturation
+        __m128d saturation = _mm_blendv_pd(_mm_div_pd(delta, max), zero, _mm_cmpeq_pd(max, zero));
+
+        storeHSVSSE41(out, j, _mm_div_pd(hue, hueDivisor), _mm_mul_pd(saturation, saturationFactor),
+                      _mm_mul_pd(max, valueFactor));
+    }
+
+    return j;
+}
+
+#endif // LEGO_SIMD
+
+/**
+ * @brief cvtRowBGRToHSVDispatch Convert row with best kernel of given level, pixels at the end
+ * of row that don't fill whole register are converted by per pixel conversion.
+ */
+template <typename ScalePolicy, typename OutT>
+inline void cvtRowBGRToHSVDispatch(const uint8_t* bgr, int n, const HSVRowOutput<OutT>& out, SimdLevel level){
+    static_assert(!std::is_same<OutT, uint8_t>::value || hsvScaleFitsByte<ScalePolicy>(), "Scale doesn't fit in 8 bits!");
+    int j = 0;
+#ifdef LEGO_SIMD
+    constexpr HSVScaleFactors f = hsvScaleFactors<ScalePolicy>();
+    if (level == SimdLevel::AVX2){
+        j = cvtRowBGRToHSVAVX2(bgr, n, f, out);
+    } else if (level == SimdLevel::SSE41){
+        j = cvtRowBGRToHSVSSE41(bgr, n, f, out);
+    }
+#else
+    (void)level;
+#endif
+    cvtRowBGRToHSVScalar<ScalePolicy>(bgr, j, n, out);
+}
+
+/**
+ * @brief cvtRowBGRToHSV Convert row of BGR pixels to interleaved HSV in scale given by policy,
+ * 8 bit values are truncated like in cvtColorBGRToHSVOwnScale, float values are not rounded.
+ * @param bgr Row of n BGR pixels.
+ * @param n Number of pixels.
+ * @param hsv Buffer for 3 * n values, uint8_t or float.
+ * @param level Instruction set to use, by default best supported by processor.
+ */
+template <typename ScalePolicy, typename OutT>
+inline void cvtRowBGRToHSV(const uint8_t* bgr, int n, OutT* hsv, SimdLevel level = detectSimdLevel()){
+    cvtRowBGRToHSVDispatch<ScalePolicy>(bgr, n, HSVRowOutput<OutT>{hsv, hsv + 1, hsv + 2, 3}, level);
+}
+
+/**
+ * @brief cvtRowBGRToHSVPlanar Convert row of BGR pixels to three planes in scale given by policy.
+ * @param bgr Row of n BGR pixels.
+ * @param n Number of pixels.
+ * @param h Buffer for n hue values, uint8_t or float.
+ * @param s Buffer for n saturation values.
+ * @param v Buffer for n value values.
+ * @param level Instruction set to use, by default best supported by processor.
+ */
+template <typename ScalePolicy, typename OutT>
+inline void cvtRowBGRToHSVPlanar(const uint8_t* bgr, int n, OutT* h, OutT* s, OutT* v, SimdLevel level = detectSimdLevel()){
+    cvtRowBGRToHSVDispatch<ScalePolicy>(bgr, n, HSVRowOutput<OutT>{h, s, v, 1}, level);
+}
+
+/**
+ * @brief The HSVMatType struct - type of image with HSV values of given type.
+ */
+template <typename OutT>
+struct HSVMatType;
+
+template <>
+struct HSVMatType<uint8_t>{
+    static constexpr int TYPE = CV_8UC3;
+};
+
+template <>
+struct HSVMatType<float>{
+    static constexpr int TYPE = CV_32FC3;
+};
+
+/**
+ * @brief cvtImgColors Convert image to HSV in scale given by policy, rows are converted by
+ * row kernels of best instruction set supported by processor.
+ * @param img Image to convertion.
+ * @return Converted image, CV_8UC3 for uint8_t and CV_32FC3 for float values.
+ */
+template <typename ScalePolicy, typename OutT>
+cv::Mat cvtImgColors(const cv::Mat& img){
+    LEGO_PROFILE_STAGE("hsv_conversion", img.total());
+    LEGO_PROFILE_MEMORY(img.total() * 3 * sizeof(OutT));
+    cv::Mat res(img.rows, img.cols, HSVMatType<OutT>::TYPE);
+
+    // image channels are read as 8 bit values
+    cv::Mat_<cv::Vec3b> original = img;
+    const SimdLevel level = detectSimdLevel();
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            cvtRowBGRToHSV<ScalePolicy>(original.ptr<uint8_t>(i), img.cols, res.ptr<OutT>(i), level);
+        }
+    });
+
+    return res;
+}
+
 /**
  * @brief cvtImgColors Covert image using given convert pixel color function.
  * @param img Image to convertion.
  * @param cvtFunc Function that convert 3 channel image pixel.
  * @return Converted image.
  */
-cv::Mat cvtImgColors(const cv::Mat& img, cvtColorFuntion cvtFunc){
+inline cv::Mat cvtImgColors(const cv::Mat& img, cvtColorFuntion cvtFunc){
     // create copy
     cv::Mat res(img.rows, img.cols, CV_8UC3);
 
@@ -223,23 +584,8 @@ cv::Mat cvtImgColors(const cv::Mat& img, cvtColorFuntion cvtFunc){
  * @param img Image to convert
  * @return Converted image, 3 float channel image!
  */
-cv::Mat cvtImgColorsToGIMPHSV(const cv::Mat& img){
-    cv::Mat res(img.rows, img.cols, CV_32FC3);
-
-    // get iterators
-    cv::Mat_<cv::Vec3b> original_iter = img;
-    cv::Mat_<cv::Vec3f> new_iter = res;
-
-    for (int i = 0; i < img.rows ; ++i){
-        for (int j = 0; j < img.cols; ++j) {
-            auto color = cvtColorBGRToHSV(original_iter(i,j)[0], original_iter(i, j)[1], original_iter(i, j)[2]);
-            new_iter(i, j)[0] = color[0]*HUE_SCALE_GIMP;
-            new_iter(i, j)[1] = color[1]*SATURATION_SCALE_GIMP;
-            new_iter(i, j)[2] = color[2]*VALUE_SCALE_GIMP;
-        }
-    }
-
-    return res;
+inline cv::Mat cvtImgColorsToGIMPHSV(const cv::Mat& img){
+    return cvtImgColors<GIMPScale, float>(img);
 }
 
 
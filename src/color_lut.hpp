@@ -0,0 +1,198 @@
+/**
+  * Lookup table of chosen colors. Decision of PixelPicker for 8 bit BGR pixel depends
+  * only on its color, so it can be checked once for each of 2^24 colors and saved as
+  * one bit - whole table takes 2 MB. Then pixels are classified straight from BGR image,
+  * without HSV image.
+  */
+
+#ifndef COLOR_LUT_HPP
+#define COLOR_LUT_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+
+// std
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+// lego
+#include "PixelPicker.hpp"
+#include "color_cvt.hpp"
+#include "parallel.hpp"
+#include "packed_pixels_map.hpp"
+
+/**
+ * @class ColorLUT
+ * @brief The ColorLUT class - one bit for each BGR color, set if color is chosen.
+ * Color index is (b << 16) | (g << 8) | r.
+ */
+class ColorLUT{
+public:
+    static const size_t COLORS = size_t(1) << 24;
+    static const int WORD_BITS = 64;
+
+private:
+    std::vector<uint64_t> words;
+
+public:
+    ColorLUT() : words(COLORS / WORD_BITS, 0) {}
+
+    static uint32_t index(uint8_t b, uint8_t g, uint8_t r){
+        return (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(g) << 8) | r;
+    }
+
+    bool get(uint8_t b, uint8_t g, uint8_t r) const {
+        uint32_t i = index(b, g, r);
+        return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1u;
+    }
+
+    void set(uint8_t b, uint8_t g, uint8_t r, bool value){
+        uint32_t i = index(b, g, r);
+        uint64_t bit = uint64_t(1) << (i % WORD_BITS);
+        words[i / WORD_BITS] = value ? (words[i / WORD_BITS] | bit) : (words[i / WORD_BITS] & ~bit);
+    }
+
+    uint64_t* data(){
+        return words.data();
+    }
+
+    const uint64_t* data() const {
+        return words.data();
+    }
+
+    /**
+     * @brief count Count chosen colors.
+     */
+    size_t count() const {
+        size_t result = 0;
+        for (auto w : words){
+            result += static_cast<size_t>(__builtin_popcountll(w));
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief The LUTChannels enum - how HSV values are given to PixelPicker when table is compiled.
+ * FLOAT_CHANNELS - float values, the same as pickPixels reads from cvtImgColorsToGIMPHSV image.
+ * BYTE_CHANNELS - values rounded to 8 bit, the same as pixelsMask and neighbour pickers read
+ * from that image.
+ */
+enum class LUTChannels{
+    FLOAT_CHANNELS,
+    BYTE_CHANNELS
+};
+
+/**
+ * @brief compileColorLUT Check each BGR color with pixel picker, colors are converted to GIMP
+ * HSV scale the same way as in cvtImgColorsToGIMPHSV.
+ * @param pp Pixel validator.
+ * @param channels How HSV values are given to pixel validator.
+ * @return Lookup table of chosen colors.
+ */
+inline ColorLUT compileColorLUT(const PixelPicker& pp, LUTChannels channels = LUTChannels::BYTE_CHANNELS){
+    ColorLUT lut;
+    uint64_t* words = lut.data();
+
+    // each blue value is 65536 colors - 1024 whole words, so tasks don't share words
+    parallelForRows(0, 256, [&](int begin, int end){
+        // all red values for one blue and green value - 4 words, checked by one classifyRow call
+        float colors[3 * 256];
+
+        for (int b = begin; b < end; ++b){
+            for (int g = 0; g < 256; ++g){
+                for (int r = 0; r < 256; ++r){
+                    double color[3];
+                    cvtColorBGRToHSV(static_cast<uint8_t>(b), static_cast<uint8_t>(g), static_cast<uint8_t>(r), color);
+
+                    // values are saved in float image first
+                    float* hsv = colors + 3 * r;
+                    hsv[0] = static_cast<float>(color[0]*HUE_SCALE_GIMP);
+                    hsv[1] = static_cast<float>(color[1]*SATURATION_SCALE_GIMP);
+                    hsv[2] = static_cast<float>(color[2]*VALUE_SCALE_GIMP);
+                    if (channels == LUTChannels::BYTE_CHANNELS){
+                        for (int c = 0; c < 3; ++c){
+                            hsv[c] = cv::saturate_cast<uint8_t>(hsv[c]);
+                        }
+                    }
+                }
+
+                pp.classifyRow(colors, 256, words + ColorLUT::index(static_cast<uint8_t>(b), static_cast<uint8_t>(g), 0) / ColorLUT::WORD_BITS);
+            }
+        }
+    });
+
+    return lut;
+}
+
+/**
+ * @brief gimpFilterLUT Lookup table of FILTER_GIMP with 8 bit channels, compiled at first use.
+ */
+inline const ColorLUT& gimpFilterLUT(){
+    static const ColorLUT lut = compileColorLUT(FILTER_GIMP, LUTChannels::BYTE_CHANNELS);
+    return lut;
+}
+
+/**
+ * @brief checkBGRImage Check if image is 8 bit BGR image.
+ * @param img Image to check.
+ */
+inline void checkBGRImage(const cv::Mat& img){
+    if (img.type() != CV_8UC3){
+        throw std::runtime_error("Image is not 8 bit BGR image!");
+    }
+}
+
+/**
+ * @brief pixelsMask Classify each pixel of BGR image using lookup table.
+ * @param img Soucre BGR image.
+ * @param lut Lookup table of chosen colors.
+ * @return One channel CV_8UC1 image, 1 for chosen pixels, 0 otherwise.
+ */
+inline cv::Mat pixelsMask(const cv::Mat& img, const ColorLUT& lut){
+    checkBGRImage(img);
+    cv::Mat mask(img.rows, img.cols, CV_8UC1);
+    const uint64_t* words = lut.data();
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            const uint8_t* src = img.ptr<uint8_t>(i);
+            uint8_t* dst = mask.ptr<uint8_t>(i);
+            for (int j = 0; j < img.cols; ++j, src += 3) {
+                uint32_t index = ColorLUT::index(src[0], src[1], src[2]);
+                dst[j] = (words[index / ColorLUT::WORD_BITS] >> (index % ColorLUT::WORD_BITS)) & 1u;
+            }
+        }
+    });
+
+    return mask;
+}
+
+/**
+ * @brief pickPixels Classify each pixel of BGR image using lookup table.
+ * @param img Soucre BGR image.
+ * @param lut Lookup table of chosen colors.
+ * @return Pixel map of true and false values.
+ */
+inline PackedPixelsMap pickPixels(const cv::Mat& img, const ColorLUT& lut){
+    checkBGRImage(img);
+    PackedPixelsMap pixelsMap(img.rows, img.cols);
+    const uint64_t* words = lut.data();
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            const uint8_t* src = img.ptr<uint8_t>(i);
+            uint64_t* dst = pixelsMap.row(i);
+            for (int j = 0; j < img.cols; ++j, src += 3) {
+                uint32_t index = ColorLUT::index(src[0], src[1], src[2]);
+                uint64_t chosen = (words[index / ColorLUT::WORD_BITS] >> (index % ColorLUT::WORD_BITS)) & 1u;
+                dst[j / PackedPixelsMap::WORD_BITS] |= chosen << (j % PackedPixelsMap::WORD_BITS);
+            }
+        }
+    });
+
+    return pixelsMap;
+}
+
+#endif // COLOR_LUT_HPP
@@ -0,0 +1,237 @@
+/**
+  * Detection results - accepted segments described by bounding box, area, centroid and
+  * moments, and writers that stream them to JSON Lines or CSV file.
+  */
+
+#ifndef DETECTION_HPP
+#define DETECTION_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/types.hpp>
+
+// std
+#include <vector>
+#include <string>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <cmath>
+
+// lego
+#include "moments.hpp"
+#include "pipeline.hpp"
+#include "morphology.hpp"
+#include "json.hpp"
+
+/**
+ * @brief The Detection struct - one accepted segment.
+ * bbox - bounding box in image coordinates, x is column and y is row.
+ * area - number of segment pixels.
+ * centroid - mean position of segment pixels, x is column and y is row.
+ * moments - invariant moments of segment.
+ */
+struct Detection{
+    unsigned int id = 0;
+    cv::Rect bbox;
+    size_t area = 0;
+    cv::Point2d centroid;
+    HuMomentSet moments;
+};
+
+/**
+ * @brief makeDetection Describe segment by its statistics.
+ * @param seg Segment statistics.
+ * @param moments Moments of segment.
+ * @return Detection of segment.
+ */
+inline Detection makeDetection(const SegmentStats& seg, const HuMomentSet& moments){
+    Detection detection;
+    detection.id = seg.id;
+    detection.bbox = cv::Rect(static_cast<int>(seg.minCol), static_cast<int>(seg.minRow),
+                              static_cast<int>(seg.maxCol - seg.minCol + 1), static_cast<int>(seg.maxRow - seg.minRow + 1));
+    detection.area = seg.count;
+    detection.centroid = cv::Point2d(seg.moments.m10 / seg.moments.m00, seg.moments.m01 / seg.moments.m00);
+    detection.moments = moments;
+    return detection;
+}
+
+/**
+ * @brief detectSegments Find segments in pixels map and describe accepted ones - not smaller
+ * than given size and with valid moments.
+ * @param pixels Map of chosen pixels.
+ * @param minSegSize Minimal number of segment pixels.
+ * @param connectivity Connectivity of segment pixels, 4 or 8.
+ * @return Detections ordered by segment ID.
+ */
+inline std::vector<Detection> detectSegments(const PackedPixelsMap& pixels, int minSegSize, int connectivity = 4){
+    checkConnectivity(connectivity);
+    std::vector<SegmentStats> chosen = removeAdditionalSegments(minSegSize, connectivity == 8 ? findSegmentStats<8>(pixels)
+                                                                                              : findSegmentStats<4>(pixels));
+
+    LEGO_PROFILE_STAGE("moments", 0);
+    std::vector<Detection> detections;
+    for (auto& seg : chosen){
+        HuMomentSet moments = getHuMoments(seg);
+        if (isValidMoments(moments)){
+            detections.emplace_back(makeDetection(seg, moments));
+        }
+    }
+    LEGO_PROFILE_COUNT("accepted_segments", detections.size());
+    return detections;
+}
+
+/**
+ * @brief detectLegoWheels Detect wheels in BGR image with default parameters of rank
+ * filter and pixels picker.
+ * @param img Source BGR image.
+ * @param minSegSize Minimal number of segment pixels.
+ * @param cleanup Optional opening and closing of pixels map before segmentation.
+ * @param connectivity Connectivity of segment pixels, 4 or 8.
+ * @return Detections ordered by segment ID.
+ */
+inline std::vector<Detection> detectLegoWheels(const cv::Mat& img, int minSegSize,
+                                               const MaskCleanup& cleanup = MaskCleanup(), int connectivity = 4){
+    PackedPixelsMap pixels = streamRankFilterPixelPicker(img, DEFUALT_RANK_FILTER_WIDTH,
+                                                         DEFUALT_RANK_FILTER_HEIGHT,
+                                                         DEFAULT_RANK_FILTER_RANK, gimpFilterLUT(),
+                                                         DEFUALT_PIX_CHOOSE_WIDTH,
+                                                         DEFUALT_PIX_CHOOSE_HEIGHT,
+                                                         DEFUALT_PIX_CHOOSE_PERCENT);
+    if (cleanup.enabled()){
+        pixels = cleanupMask(pixels, cleanup);
+    }
+    return detectSegments(pixels, minSegSize, connectivity);
+}
+
+/**
+ * @brief drawDetections Draw bounding rects of detections in given image.
+ * @param img Image in which will be drawn bounding rects.
+ * @param detections Detections to draw.
+ */
+inline void drawDetections(cv::Mat& img, const std::vector<Detection>& detections){
+    LEGO_PROFILE_STAGE("drawing", 0);
+    for (auto& d : detections){
+        drawBoundingRect(img, { static_cast<unsigned int>(d.bbox.y), static_cast<unsigned int>(d.bbox.y + d.bbox.height - 1),
+                                static_cast<unsigned int>(d.bbox.x), static_cast<unsigned int>(d.bbox.x + d.bbox.width - 1) });
+    }
+}
+
+/**
+ * @brief The DetectionFormat enum - format of detections file.
+ * JSON_LINES - one JSON object for each image, with array of its detections.
+ * CSV - header and one line for each detection, values are separated by ';'.
+ */
+enum class DetectionFormat{
+    JSON_LINES,
+    CSV
+};
+
+/**
+ * @class DetectionWriter
+ * @brief The DetectionWriter class - writes detections of images to stream as soon as image
+ * is processed, so results are not gathered in memory. Writing is synchronized, so one writer
+ * can be used by many threads.
+ */
+class DetectionWriter{
+private:
+    std::ostream& out;
+    DetectionFormat format;
+    bool headerWritten;
+    std::mutex mutex;
+
+    // CSV field is quoted by RFC 4180 if it contains separator, quote or line break, quotes are doubled
+    static std::string csvField(const std::string& text){
+        if (text.find_first_of(";\"\r\n") == std::string::npos){
+            return text;
+        }
+        std::string result = "\"";
+        for (char c : text){
+            result += (c == '"') ? "\"\"" : std::string(1, c);
+        }
+        return result + "\"";
+    }
+
+    // numbers are written with full precision, JSON has no NaN and infinity, so they are null
+    static void writeNumber(std::ostream& stream, double value, bool json){
+        if (json && !std::isfinite(value)){
+            stream << "null";
+        } else {
+            stream << value;
+        }
+    }
+
+    void writeJSON(std::ostream& stream, const std::string& image, const std::vector<Detection>& detections){
+        stream << "{\"image\":" << jsonString(image) << ",\"detections\":[";
+        for (size_t i = 0; i < detections.size(); ++i){
+            const Detection& d = detections[i];
+            stream << (i ? "," : "") << "{\"id\":" << d.id
+                   << ",\"bbox\":{\"x\":" << d.bbox.x << ",\"y\":" << d.bbox.y
+                   << ",\"width\":" << d.bbox.width << ",\"height\":" << d.bbox.height << "}"
+                   << ",\"area\":" << d.area << ",\"centroid\":{\"x\":";
+            writeNumber(stream, d.centroid.x, true);
+            stream << ",\"y\":";
+            writeNumber(stream, d.centroid.y, true);
+            stream << "},\"moments\":{";
+            for (size_t m = 0; m < HuMomentSet::SIZE; ++m){
+                stream << (m ? "," : "") << "\"" << HuMomentSet::name(m) << "\":";
+                writeNumber(stream, d.moments[m], true);
+            }
+            stream << "}}";
+        }
+        stream << "]}\n";
+    }
+
+    void writeCSV(std::ostream& stream, const std::string& image, const std::vector<Detection>& detections){
+        for (auto& d : detections){
+            stream << csvField(image) << ";" << d.id << ";" << d.bbox.x << ";" << d.bbox.y << ";" << d.bbox.width << ";"
+                   << d.bbox.height << ";" << d.area << ";";
+            writeNumber(stream, d.centroid.x, false);
+            stream << ";";
+            writeNumber(stream, d.centroid.y, false);
+            for (size_t m = 0; m < HuMomentSet::SIZE; ++m){
+                stream << ";";
+                writeNumber(stream, d.moments[m], false);
+            }
+            stream << "\n";
+        }
+    }
+
+public:
+    DetectionWriter(std::ostream& out, DetectionFormat format) : out(out), format(format), headerWritten(false) {}
+
+    DetectionWriter(const DetectionWriter&) = delete;
+    DetectionWriter& operator=(const DetectionWriter&) = delete;
+
+    /**
+     * @brief write Write detections of one image and flush stream.
+     * @param image Name of image.
+     * @param detections Detections in image.
+     */
+    void write(const std::string& image, const std::vector<Detection>& detections){
+        // text is prepared before lock
+        std::ostringstream stream;
+        stream << std::setprecision(std::numeric_limits<double>::max_digits10);
+        if (format == DetectionFormat::JSON_LINES){
+            writeJSON(stream, image, detections);
+        } else {
+            writeCSV(stream, image, detections);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (format == DetectionFormat::CSV && !headerWritten){
+            out << "image;id;x;y;width;height;area;centroid_x;centroid_y";
+            for (size_t m = 0; m < HuMomentSet::SIZE; ++m){
+                out << ";" << HuMomentSet::name(m);
+            }
+            out << "\n";
+            headerWritten = true;
+        }
+        out << stream.str();
+        out.flush();
+    }
+};
+
+#endif // DETECTION_HPP
@@ -0,0 +1,39 @@
+/**
+  * Helpers of JSON output shared by writers of detections and profile reports.
+  */
+
+#ifndef JSON_HPP
+#define JSON_HPP
+
+// std
+#include <string>
+#include <cstdio>
+
+/**
+ * @brief jsonString Quote text as JSON string, escapes quotes, backslashes and control characters.
+ * @param text Text to quote.
+ * @return JSON string with quotes.
+ */
+inline std::string jsonString(const std::string& text){
+    std::string result = "\"";
+    for (char c : text){
+        switch (c){
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20){
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                result += escaped;
+            } else {
+                result += c;
+            }
+        }
+    }
+    return result + "\"";
+}
+
+#endif // JSON_HPP
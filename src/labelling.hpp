@@ -0,0 +1,940 @@
+/**
+  * Two pass connected component labelling (SAUF - scan plus array based union-find).
+  * First pass gives provisional labels and records equivalences, second pass
+  * replaces provisional labels with final ones. Run based variant labels whole
+  * horizontal runs of chosen pixels instead of single pixels.
+  * Parallel variants split map into horizontal strips, each strip is labelled by its own
+  * thread with its own labels, then labels of strips are moved to separate ranges of one
+  * table and merged along strip borders. Labels of later strips are greater, so components
+  * keep the order of their first pixel and result is the same as from sequential labelling.
+  * Block based variant labels blocks of two pixels of one column in pair of rows - both
+  * pixels of block are 4-connected, so block has one label and half of label reads and
+  * writes is needed. Decisions for 64 blocks are counted at once from words of pixels map.
+  * All labellers take connectivity (4 or 8) as template parameter, 8-connected variants are
+  * single pass too and decide which neighbours are chosen from bits of pixels map.
+  */
+
+#ifndef LABELLING_HPP
+#define LABELLING_HPP
+
+// std
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <stdexcept>
+
+// lego
+#include "packed_pixels_map.hpp"
+#include "parallel.hpp"
+
+// minimal number of rows of strip labelled by one thread
+const int MIN_LABELLING_STRIP_ROWS = 32;
+
+/**
+ * @brief checkConnectivity Check if connectivity given at runtime is 4 or 8.
+ */
+inline void checkConnectivity(int connectivity){
+    if (connectivity != 4 && connectivity != 8){
+        throw std::runtime_error("Connectivity must be 4 or 8!");
+    }
+}
+
+/**
+ * @class EquivalenceTable
+ * @brief The EquivalenceTable class - array based union-find of provisional labels. Root of
+ * each set is its lowest label, label 0 is background.
+ */
+class EquivalenceTable{
+private:
+    std::vector<uint32_t> parent;
+
+public:
+    EquivalenceTable(){
+        parent.emplace_back(0);
+    }
+
+    /**
+     * @brief newLabel Create new label in its own set.
+     * @return New label.
+     */
+    uint32_t newLabel(){
+        uint32_t label = static_cast<uint32_t>(parent.size());
+        parent.emplace_back(label);
+        return label;
+    }
+
+    /**
+     * @brief find Find root of set with given label, compress path on the way.
+     */
+    uint32_t find(uint32_t label){
+        uint32_t root = label;
+        while (parent[root] != root){
+            root = parent[root];
+        }
+        while (parent[label] != root){
+            uint32_t next = parent[label];
+            parent[label] = root;
+            label = next;
+        }
+        return root;
+    }
+
+    /**
+     * @brief merge Merge sets of given labels.
+     * @return Root of merged set.
+     */
+    uint32_t merge(uint32_t a, uint32_t b){
+        uint32_t rootA = find(a);
+        uint32_t rootB = find(b);
+        if (rootA < rootB){
+            parent[rootB] = rootA;
+            return rootA;
+        }
+        parent[rootA] = rootB;
+        return rootB;
+    }
+
+    /**
+     * @brief flatten Replace each label with final label. Final labels are consecutive,
+     * ordered by lowest provisional label of set.
+     * @return Number of final labels.
+     */
+    uint32_t flatten(){
+        uint32_t count = 0;
+        for (size_t label = 1; label < parent.size(); ++label){
+            if (parent[label] == label){
+                parent[label] = ++count;
+            } else {
+                // parent is lower, so it has final label already
+                parent[label] = parent[parent[label]];
+            }
+        }
+        return count;
+    }
+
+    uint32_t operator[](uint32_t label) const {
+        return parent[label];
+    }
+
+    size_t size() const {
+        return parent.size();
+    }
+};
+
+/**
+ * @class ConcurrentEquivalenceTable
+ * @brief The ConcurrentEquivalenceTable class - union-find of provisional labels that can be
+ * merged by many threads at once. Root of each set is its lowest label as in EquivalenceTable,
+ * merge links greater root to lower one by compare and swap and tries again if root changed.
+ */
+class ConcurrentEquivalenceTable{
+private:
+    std::vector<std::atomic<uint32_t>> parent;
+
+public:
+    explicit ConcurrentEquivalenceTable(size_t size) : parent(size) {
+        for (size_t label = 0; label < size; ++label){
+            parent[label].store(static_cast<uint32_t>(label), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief link Set parent of label, used to fill table before merging. Parent must not be
+     * greater than label.
+     */
+    void link(uint32_t label, uint32_t root){
+        parent[label].store(root, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief find Find root of set with given label.
+     */
+    uint32_t find(uint32_t label) const {
+        uint32_t next = parent[label].load(std::memory_order_acquire);
+        while (next != label){
+            label = next;
+            next = parent[label].load(std::memory_order_acquire);
+        }
+        return label;
+    }
+
+    /**
+     * @brief merge Merge sets of given labels, can be called by many threads.
+     */
+    void merge(uint32_t a, uint32_t b){
+        while (true){
+            a = find(a);
+            b = find(b);
+            if (a == b){
+                return;
+            }
+            if (a < b){
+                std::swap(a, b);
+            }
+            // a is still root only if no other thread linked it
+            uint32_t expected = a;
+            if (parent[a].compare_exchange_weak(expected, b, std::memory_order_acq_rel)){
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief flatten Replace each label with final label, the same as in EquivalenceTable.
+     * It must not be called during merging.
+     * @return Number of final labels.
+     */
+    uint32_t flatten(){
+        uint32_t count = 0;
+        for (size_t label = 1; label < parent.size(); ++label){
+            uint32_t up = parent[label].load(std::memory_order_relaxed);
+            if (up == label){
+                parent[label].store(++count, std::memory_order_relaxed);
+            } else {
+                // parent is lower, so it has final label already
+                parent[label].store(parent[up].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+        return count;
+    }
+
+    uint32_t operator[](uint32_t label) const {
+        return parent[label].load(std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        return parent.size();
+    }
+};
+
+/**
+ * @brief labellingStrips Split rows into strips labelled by separate threads.
+ * @param rows Number of rows.
+ * @return Strips, one for each thread, but not thinner than MIN_LABELLING_STRIP_ROWS.
+ */
+inline std::vector<RowBand> labellingStrips(int rows){
+    unsigned int strips = std::min(getThreadsNumber(), static_cast<unsigned int>(std::max(1, rows / MIN_LABELLING_STRIP_ROWS)));
+    return splitRowBands(0, rows, strips);
+}
+
+/**
+ * @brief joinStripTables Move labels of strips tables to separate ranges of one table, labels
+ * of strip s are shifted by offsets[s].
+ * @param tables Equivalences of each strip.
+ * @param offsets Result - shift of labels of each strip.
+ * @return Table with all labels.
+ */
+inline ConcurrentEquivalenceTable joinStripTables(std::vector<EquivalenceTable>& tables, std::vector<uint32_t>& offsets){
+    offsets.assign(tables.size(), 0);
+    size_t total = 1;
+    for (size_t s = 0; s < tables.size(); ++s){
+        offsets[s] = static_cast<uint32_t>(total - 1);
+        total += tables[s].size() - 1;
+    }
+
+    ConcurrentEquivalenceTable table(total);
+    parallelForRows(0, static_cast<int>(tables.size()), [&](int begin, int end){
+        for (int s = begin; s < end; ++s){
+            for (uint32_t label = 1; label < tables[s].size(); ++label){
+                table.link(offsets[s] + label, offsets[s] + tables[s].find(label));
+            }
+        }
+    });
+    return table;
+}
+
+/**
+ * @brief The LabelImage struct - label of each pixel, 0 for background. Labels are numbered
+ * from 1 in order of first pixel (in row by row scan) of each component.
+ */
+struct LabelImage{
+    int rows;
+    int cols;
+    uint32_t count;
+    std::vector<uint32_t> labels;
+
+    uint32_t* row(int i){
+        return labels.data() + static_cast<size_t>(cols) * i;
+    }
+
+    const uint32_t* row(int i) const {
+        return labels.data() + static_cast<size_t>(cols) * i;
+    }
+};
+
+/**
+ * @brief leftNeighbourBits Bits of left neighbours of pixels of word - bit i is pixel of column
+ * before pixel i.
+ * @param words Row of pixels map.
+ * @param w Word index.
+ */
+inline uint64_t leftNeighbourBits(const uint64_t* words, size_t w){
+    return (words[w] << 1) | (w > 0 ? words[w - 1] >> (PackedPixelsMap::WORD_BITS - 1) : 0);
+}
+
+/**
+ * @brief rightNeighbourBits Bits of right neighbours of pixels of word - bit i is pixel of column
+ * after pixel i. Padding bits of last word are not chosen, so last column has no right neighbour.
+ * @param words Row of pixels map.
+ * @param w Word index.
+ * @param wordsNumber Number of words in row.
+ */
+inline uint64_t rightNeighbourBits(const uint64_t* words, size_t w, size_t wordsNumber){
+    return (words[w] >> 1) | (w + 1 < wordsNumber ? words[w + 1] << (PackedPixelsMap::WORD_BITS - 1) : 0);
+}
+
+/**
+ * @brief labelRows First pass of labelling of rows [begin, end) - provisional labels of given
+ * table, only chosen pixels are visited. Row before begin is not checked, so strips of rows
+ * can be labelled separately. In 8-connectivity decision tree of Wu et al. is used - upper
+ * pixel is connected with all other neighbours, so it is checked first. Decisions use bits of
+ * pixels map and only label of chosen neighbour is read.
+ * @param pixels Map of chosen pixels.
+ * @param begin First row.
+ * @param end Row after last one.
+ * @param result Label image, provisional labels are written to its rows.
+ * @param table Equivalences of provisional labels.
+ */
+template <int Connectivity = 4>
+void labelRows(const PackedPixelsMap& pixels, int begin, int end, LabelImage& result, EquivalenceTable& table){
+    static_assert(Connectivity == 4 || Connectivity == 8, "Connectivity must be 4 or 8");
+    const size_t wordsNumber = pixels.wordsInRow();
+
+    for (int row = begin; row < end; ++row){
+        const uint64_t* words = pixels.row(row);
+        const uint64_t* upperWords = row > begin ? pixels.row(row - 1) : nullptr;
+        uint32_t* current = result.row(row);
+        const uint32_t* upper = row > begin ? result.row(row - 1) : nullptr;
+
+        for (size_t w = 0; w < wordsNumber; ++w){
+            uint64_t word = words[w];
+            if (word == 0){
+                continue;
+            }
+
+            // neighbours of 8-connectivity
+            uint64_t upLeft = 0, up = 0, upRight = 0, left = 0;
+            if (Connectivity == 8){
+                left = leftNeighbourBits(words, w);
+                if (upperWords){
+                    upLeft = leftNeighbourBits(upperWords, w);
+                    up = upperWords[w];
+                    upRight = rightNeighbourBits(upperWords, w, wordsNumber);
+                }
+            }
+
+            while (word != 0){
+                const int bit = __builtin_ctzll(word);
+                const int col = static_cast<int>(w * PackedPixelsMap::WORD_BITS) + bit;
+                word &= word - 1;
+
+                if (Connectivity == 8){
+                    const uint64_t mask = uint64_t(1) << bit;
+                    if (up & mask){
+                        current[col] = upper[col];
+                    } else if (upRight & mask){
+                        if (upLeft & mask){
+                            current[col] = table.merge(upper[col + 1], upper[col - 1]);
+                        } else if (left & mask){
+                            current[col] = table.merge(upper[col + 1], current[col - 1]);
+                        } else {
+                            current[col] = upper[col + 1];
+                        }
+                    } else if (upLeft & mask){
+                        current[col] = upper[col - 1];
+                    } else if (left & mask){
+                        current[col] = current[col - 1];
+                    } else {
+                        current[col] = table.newLabel();
+                    }
+                    continue;
+                }
+
+                uint32_t leftLabel = col > 0 ? current[col - 1] : 0;
+                uint32_t upLabel = upper ? upper[col] : 0;
+
+                if (leftLabel == 0 && upLabel == 0){
+                    current[col] = table.newLabel();
+                } else if (leftLabel == 0){
+                    current[col] = upLabel;
+                } else if (upLabel == 0 || upLabel == leftLabel){
+                    current[col] = leftLabel;
+                } else {
+                    current[col] = table.merge(leftLabel, upLabel);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief labelComponents Label 4-connected or 8-connected components of chosen pixels.
+ * @param pixels Map of chosen pixels.
+ * @return Label image.
+ */
+template <int Connectivity = 4>
+LabelImage labelComponents(const PackedPixelsMap& pixels){
+    LabelImage result;
+    result.rows = pixels.rows();
+    result.cols = pixels.cols();
+    result.labels.assign(static_cast<size_t>(result.rows) * result.cols, 0);
+
+    EquivalenceTable table;
+    labelRows<Connectivity>(pixels, 0, result.rows, result, table);
+
+    // second pass - final labels
+    result.count = table.flatten();
+    for (auto& label : result.labels){
+        label = table[label];
+    }
+
+    return result;
+}
+
+/**
+ * @brief labelComponentsParallel Label 4-connected or 8-connected components of chosen pixels,
+ * strips of rows are labelled in parallel. Result is the same as from labelComponents.
+ * @param pixels Map of chosen pixels.
+ * @return Label image.
+ */
+template <int Connectivity = 4>
+LabelImage labelComponentsParallel(const PackedPixelsMap& pixels){
+    LabelImage result;
+    result.rows = pixels.rows();
+    result.cols = pixels.cols();
+    result.labels.assign(static_cast<size_t>(result.rows) * result.cols, 0);
+
+    std::vector<RowBand> strips = labellingStrips(result.rows);
+    const int stripsNumber = static_cast<int>(strips.size());
+
+    // first pass of each strip with its own labels
+    std::vector<EquivalenceTable> tables(strips.size());
+    parallelForRows(0, stripsNumber, [&](int begin, int end){
+        for (int s = begin; s < end; ++s){
+            labelRows<Connectivity>(pixels, strips[s].begin, strips[s].end, result, tables[s]);
+        }
+    });
+
+    std::vector<uint32_t> offsets;
+    ConcurrentEquivalenceTable table = joinStripTables(tables, offsets);
+
+    // merge pixels of first row of strip with pixels of last row of previous strip
+    parallelForRows(1, stripsNumber, [&](int begin, int end){
+        const size_t wordsNumber = pixels.wordsInRow();
+        for (int s = begin; s < end; ++s){
+            const int row = strips[s].begin;
+            const uint64_t* upperWords = pixels.row(row - 1);
+            const uint64_t* words = pixels.row(row);
+            const uint32_t* upper = result.row(row - 1);
+            const uint32_t* current = result.row(row);
+            uint32_t lastUp = 0, lastCurrent = 0;
+
+            auto mergePair = [&](int upperCol, int col){
+                // neighbouring columns of the same runs give the same pair
+                if (upper[upperCol] != lastUp || current[col] != lastCurrent){
+                    lastUp = upper[upperCol];
+                    lastCurrent = current[col];
+                    table.merge(offsets[s - 1] + lastUp, offsets[s] + lastCurrent);
+                }
+            };
+
+            for (size_t w = 0; w < wordsNumber; ++w){
+                const uint64_t up = upperWords[w] & words[w];
+                const uint64_t upLeft = Connectivity == 8 ? leftNeighbourBits(upperWords, w) & words[w] : 0;
+                const uint64_t upRight = Connectivity == 8 ? rightNeighbourBits(upperWords, w, wordsNumber) & words[w] : 0;
+
+                uint64_t linked = up | upLeft | upRight;
+                while (linked != 0){
+                    const int bit = __builtin_ctzll(linked);
+                    const int col = static_cast<int>(w * PackedPixelsMap::WORD_BITS) + bit;
+                    const uint64_t mask = uint64_t(1) << bit;
+                    linked &= linked - 1;
+
+                    if (upLeft & mask){
+                        mergePair(col - 1, col);
+                    }
+                    if (up & mask){
+                        mergePair(col, col);
+                    }
+                    if (upRight & mask){
+                        mergePair(col + 1, col);
+                    }
+                }
+            }
+        }
+    });
+
+    // second pass - final labels
+    result.count = table.flatten();
+    parallelForRows(0, stripsNumber, [&](int begin, int end){
+        for (int s = begin; s < end; ++s){
+            for (int row = strips[s].begin; row < strips[s].end; ++row){
+                uint32_t* current = result.row(row);
+                for (int col = 0; col < result.cols; ++col){
+                    if (current[col] != 0){
+                        current[col] = table[offsets[s] + current[col]];
+                    }
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+/**
+ * @brief labelComponentsBlocks Label 4-connected or 8-connected components of chosen pixels
+ * by blocks of two pixels of column. In 4-connectivity block is connected with left block if
+ * its top or bottom pixel has left neighbour and with upper block if its top pixel has upper
+ * neighbour. In 8-connectivity any two non empty neighbouring blocks of pair of rows are
+ * connected and top pixel is connected with three upper blocks. Result is the same as from
+ * labelComponents.
+ * @param pixels Map of chosen pixels.
+ * @return Label image.
+ */
+template <int Connectivity = 4>
+LabelImage labelComponentsBlocks(const PackedPixelsMap& pixels){
+    static_assert(Connectivity == 4 || Connectivity == 8, "Connectivity must be 4 or 8");
+
+    LabelImage result;
+    result.rows = pixels.rows();
+    result.cols = pixels.cols();
+    result.labels.assign(static_cast<size_t>(result.rows) * result.cols, 0);
+
+    const int cols = result.cols;
+    const int pairs = (result.rows + 1) / 2;
+    const size_t words = pixels.wordsInRow();
+    const std::vector<uint64_t> empty(words, 0);
+    std::vector<uint32_t> blockLabels(static_cast<size_t>(pairs) * cols, 0);
+    EquivalenceTable table;
+
+    // first pass - provisional labels of blocks, only blocks with chosen pixels are visited
+    for (int pair = 0; pair < pairs; ++pair){
+        const int row = 2 * pair;
+        const uint64_t* top = pixels.row(row);
+        const uint64_t* bottom = row + 1 < result.rows ? pixels.row(row + 1) : empty.data();
+        const uint64_t* upperBottom = pair > 0 ? pixels.row(row - 1) : empty.data();
+        uint32_t* current = blockLabels.data() + static_cast<size_t>(pair) * cols;
+        const uint32_t* upper = pair > 0 ? current - cols : nullptr;
+
+        for (size_t w = 0; w < words; ++w){
+            const uint64_t t = top[w], b = bottom[w];
+            uint64_t blocks = t | b;
+            if (blocks == 0){
+                continue;
+            }
+
+            const uint64_t left = Connectivity == 8
+                    ? blocks & (leftNeighbourBits(top, w) | leftNeighbourBits(bottom, w))
+                    : (t & leftNeighbourBits(top, w)) | (b & leftNeighbourBits(bottom, w));
+            const uint64_t up = t & upperBottom[w];
+            const uint64_t upLeft = Connectivity == 8 ? t & leftNeighbourBits(upperBottom, w) : 0;
+            const uint64_t upRight = Connectivity == 8 ? t & rightNeighbourBits(upperBottom, w, words) : 0;
+
+            while (blocks != 0){
+                const int bit = __builtin_ctzll(blocks);
+                const int col = static_cast<int>(w * PackedPixelsMap::WORD_BITS) + bit;
+                const uint64_t mask = uint64_t(1) << bit;
+                blocks &= blocks - 1;
+
+                // upper block is connected with upper left and upper right ones, left block
+                // can have only bottom pixel, so it is merged with upper ones
+                uint32_t label = 0;
+                if (up & mask){
+                    label = upper[col];
+                } else {
+                    if (upLeft & mask){
+                        label = upper[col - 1];
+                    }
+                    if (upRight & mask){
+                        label = label == 0 ? upper[col + 1] : table.merge(label, upper[col + 1]);
+                    }
+                }
+                if (left & mask){
+                    label = (label == 0 || label == current[col - 1]) ? current[col - 1] : table.merge(label, current[col - 1]);
+                }
+                current[col] = label == 0 ? table.newLabel() : label;
+            }
+        }
+    }
+
+    // second pass - blocks are visited by pairs of rows, so components are numbered again
+    // in order of their first pixel
+    std::vector<uint32_t> order(table.flatten() + 1, 0);
+    result.count = 0;
+    for (int row = 0; row < result.rows; ++row){
+        const uint64_t* rowWords = pixels.row(row);
+        const uint32_t* blocksRow = blockLabels.data() + static_cast<size_t>(row / 2) * cols;
+        uint32_t* current = result.row(row);
+
+        for (size_t w = 0; w < words; ++w){
+            uint64_t word = rowWords[w];
+            while (word != 0){
+                int col = static_cast<int>(w * PackedPixelsMap::WORD_BITS) + __builtin_ctzll(word);
+                word &= word - 1;
+
+                uint32_t& label = order[table[blocksRow[col]]];
+                if (label == 0){
+                    label = ++result.count;
+                }
+                current[col] = label;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief The PixelRun struct - horizontal run of chosen pixels, columns [colStart, colEnd) of row.
+ */
+struct PixelRun{
+    unsigned int row;
+    unsigned int colStart;
+    unsigned int colEnd;
+};
+
+/**
+ * @brief The RawMoments struct - raw moments of segment, x is column and y is row of pixel.
+ */
+struct RawMoments{
+    double m00 = 0.0, m01 = 0.0, m10 = 0.0, m11 = 0.0, m20 = 0.0, m02 = 0.0, m21 = 0.0, m12 = 0.0, m30 = 0.0, m03 = 0.0;
+
+    /**
+     * @brief addPixel Add pixel to moments.
+     * @param row Pixel row.
+     * @param col Pixel column.
+     */
+    void addPixel(unsigned int row, unsigned int col){
+        m00 += 1.0;
+        m10 += static_cast<double>(col);
+        m01 += static_cast<double>(row);
+        m11 += static_cast<double>(row) * static_cast<double>(col);
+        m20 += std::pow(static_cast<double>(col), 2.0);
+        m02 += std::pow(static_cast<double>(row), 2.0);
+        m21 += std::pow(static_cast<double>(col), 2.0) * static_cast<double>(row);
+        m12 += std::pow(static_cast<double>(row), 2.0) * static_cast<double>(col);
+        m30 += std::pow(static_cast<double>(col), 3.0);
+        m03 += std::pow(static_cast<double>(row), 3.0);
+    }
+
+    /**
+     * @brief addRun Add all pixels of run to moments. Sums of column powers are counted
+     * from closed formulas as integers, so result is the same as from addPixel for each pixel.
+     * @param run Run of pixels.
+     */
+    void addRun(const PixelRun& run){
+        // sums of x^k for x in [0, n)
+        auto s1 = [](uint64_t n) -> uint64_t { return n * (n - 1) / 2; };
+        auto s2 = [](uint64_t n) -> uint64_t { return n == 0 ? 0 : (n - 1) * n * (2 * n - 1) / 6; };
+        auto s3 = [&s1](uint64_t n) -> uint64_t { return s1(n) * s1(n); };
+
+        const uint64_t a = run.colStart, b = run.colEnd;
+        const double n = static_cast<double>(b - a);
+        const double x1 = static_cast<double>(s1(b) - s1(a));
+        const double x2 = static_cast<double>(s2(b) - s2(a));
+        const double x3 = static_cast<double>(s3(b) - s3(a));
+        const double y = static_cast<double>(run.row);
+
+        m00 += n;
+        m10 += x1;
+        m01 += y * n;
+        m11 += y * x1;
+        m20 += x2;
+        m02 += y * y * n;
+        m21 += x2 * y;
+        m12 += y * y * x1;
+        m30 += x3;
+        m03 += y * y * y * n;
+    }
+
+    /**
+     * @brief merge Add raw moments of other part of the same segment.
+     * @param other Raw moments to add.
+     */
+    void merge(const RawMoments& other){
+        m00 += other.m00;
+        m01 += other.m01;
+        m10 += other.m10;
+        m11 += other.m11;
+        m20 += other.m20;
+        m02 += other.m02;
+        m21 += other.m21;
+        m12 += other.m12;
+        m30 += other.m30;
+        m03 += other.m03;
+    }
+};
+
+/**
+ * @brief The SegmentStats struct - statistics of segment collected during labelling: number
+ * of pixels, bounding box and raw moments, so segment can be checked without its pixels.
+ */
+struct SegmentStats{
+    unsigned int id = 0;
+    size_t count = 0;
+    unsigned int minRow = std::numeric_limits<unsigned int>::max();
+    unsigned int maxRow = 0;
+    unsigned int minCol = std::numeric_limits<unsigned int>::max();
+    unsigned int maxCol = 0;
+    RawMoments moments;
+
+    /**
+     * @brief addRun Add all pixels of run to statistics.
+     * @param run Run of pixels.
+     */
+    void addRun(const PixelRun& run){
+        count += run.colEnd - run.colStart;
+        minRow = std::min(minRow, run.row);
+        maxRow = std::max(maxRow, run.row);
+        minCol = std::min(minCol, run.colStart);
+        maxCol = std::max(maxCol, run.colEnd - 1);
+        moments.addRun(run);
+    }
+
+    /**
+     * @brief merge Add statistics of other part of the same segment.
+     * @param other Statistics to add.
+     */
+    void merge(const SegmentStats& other){
+        count += other.count;
+        minRow = std::min(minRow, other.minRow);
+        maxRow = std::max(maxRow, other.maxRow);
+        minCol = std::min(minCol, other.minCol);
+        maxCol = std::max(maxCol, other.maxCol);
+        moments.merge(other.moments);
+    }
+};
+
+/**
+ * @brief extractRuns Find maximal runs of chosen pixels in one row, whole words of the same
+ * bits are skipped.
+ * @param pixels Map of chosen pixels.
+ * @param row Row index.
+ * @param runs Vector to which runs are appended.
+ */
+inline void extractRuns(const PackedPixelsMap& pixels, int row, std::vector<PixelRun>& runs){
+    const uint64_t* words = pixels.row(row);
+    bool open = false;
+    unsigned int start = 0;
+
+    for (size_t w = 0; w < pixels.wordsInRow(); ++w){
+        const uint64_t word = words[w];
+        const unsigned int base = static_cast<unsigned int>(w * PackedPixelsMap::WORD_BITS);
+        unsigned int pos = 0;
+
+        while (pos < PackedPixelsMap::WORD_BITS){
+            // looking for first chosen pixel or first not chosen one
+            uint64_t rest = (open ? ~word : word) >> pos;
+            if (rest == 0){
+                break;
+            }
+            pos += __builtin_ctzll(rest);
+            if (open){
+                runs.push_back({static_cast<unsigned int>(row), start, base + pos});
+            } else {
+                start = base + pos;
+            }
+            open = !open;
+        }
+    }
+
+    if (open){
+        runs.push_back({static_cast<unsigned int>(row), start, static_cast<unsigned int>(pixels.cols())});
+    }
+}
+
+/**
+ * @brief The RunLabelling struct - runs of chosen pixels in row by row order and final label
+ * of each run. Labels are numbered from 1 in the same order as in LabelImage.
+ */
+struct RunLabelling{
+    uint32_t count;
+    std::vector<PixelRun> runs;
+    std::vector<uint32_t> labels;
+};
+
+/**
+ * @brief scanRuns First pass of run based labelling - give provisional label to each run.
+ * Two runs from neighbouring rows are connected if they have common column, in 8-connectivity
+ * also if they touch by corners. Only runs of current and previous row are kept.
+ * @param pixels Map of chosen pixels.
+ * @param begin First row.
+ * @param end Row after last one, row before begin is not checked.
+ * @param table Equivalences of provisional labels.
+ * @param onRun Function called with each run and its provisional label.
+ */
+template <int Connectivity = 4, typename OnRun>
+void scanRuns(const PackedPixelsMap& pixels, int begin, int end, EquivalenceTable& table, OnRun onRun){
+    static_assert(Connectivity == 4 || Connectivity == 8, "Connectivity must be 4 or 8");
+    const unsigned int reach = Connectivity == 8 ? 1 : 0;
+    std::vector<PixelRun> previousRuns, currentRuns;
+    std::vector<uint32_t> previousLabels, currentLabels;
+
+    for (int row = begin; row < end; ++row){
+        currentRuns.clear();
+        currentLabels.clear();
+        extractRuns(pixels, row, currentRuns);
+
+        // runs of both rows are sorted, so previous row is scanned only once
+        size_t p = 0;
+        for (auto& run : currentRuns){
+            while (p < previousRuns.size() && previousRuns[p].colEnd + reach <= run.colStart){
+                ++p;
+            }
+
+            uint32_t label = 0;
+            size_t q = p;
+            while (q < previousRuns.size() && previousRuns[q].colStart < run.colEnd + reach){
+                label = label == 0 ? previousLabels[q] : table.merge(label, previousLabels[q]);
+                ++q;
+            }
+            // last overlapping run can overlap next run too
+            if (q > p){
+                p = q - 1;
+            }
+
+            label = label == 0 ? table.newLabel() : label;
+            currentLabels.emplace_back(label);
+            onRun(run, label);
+        }
+
+        std::swap(previousRuns, currentRuns);
+        std::swap(previousLabels, currentLabels);
+    }
+}
+
+/**
+ * @brief labelRuns Label 4-connected or 8-connected components of chosen pixels using runs.
+ * @param pixels Map of chosen pixels.
+ * @return Runs and their labels.
+ */
+template <int Connectivity = 4>
+RunLabelling labelRuns(const PackedPixelsMap& pixels){
+    RunLabelling result;
+    EquivalenceTable table;
+
+    scanRuns<Connectivity>(pixels, 0, pixels.rows(), table, [&result](const PixelRun& run, uint32_t label){
+        result.runs.emplace_back(run);
+        result.labels.emplace_back(label);
+    });
+
+    result.count = table.flatten();
+    for (auto& label : result.labels){
+        label = table[label];
+    }
+
+    return result;
+}
+
+/**
+ * @brief labelStats Label 4-connected or 8-connected components of chosen pixels and collect
+ * statistics of each of them. Statistics are collected for provisional labels and merged at
+ * the end, runs are not stored.
+ * @param pixels Map of chosen pixels.
+ * @return Statistics of components, ordered by label (the same as in labelRuns).
+ */
+template <int Connectivity = 4>
+std::vector<SegmentStats> labelStats(const PackedPixelsMap& pixels){
+    EquivalenceTable table;
+    std::vector<SegmentStats> provisional(1);
+
+    scanRuns<Connectivity>(pixels, 0, pixels.rows(), table, [&provisional](const PixelRun& run, uint32_t label){
+        if (label >= provisional.size()){
+            provisional.resize(label + 1);
+        }
+        provisional[label].addRun(run);
+    });
+
+    std::vector<SegmentStats> result(table.flatten());
+    for (uint32_t label = 1; label < provisional.size(); ++label){
+        result[table[label] - 1].merge(provisional[label]);
+    }
+    for (size_t i = 0; i < result.size(); ++i){
+        result[i].id = static_cast<unsigned int>(i + 1);
+    }
+
+    return result;
+}
+
+/**
+ * @brief labelStatsParallel Label 4-connected or 8-connected components of chosen pixels and
+ * collect their statistics, strips of rows are scanned in parallel. Moments are sums of
+ * integers, so result is the same as from labelStats.
+ * @param pixels Map of chosen pixels.
+ * @return Statistics of components, ordered by label (the same as in labelRuns).
+ */
+template <int Connectivity = 4>
+std::vector<SegmentStats> labelStatsParallel(const PackedPixelsMap& pixels){
+    const unsigned int reach = Connectivity == 8 ? 1 : 0;
+    std::vector<RowBand> strips = labellingStrips(pixels.rows());
+    const int stripsNumber = static_cast<int>(strips.size());
+
+    // statistics of provisional labels of each strip, runs of first and last row of strip
+    // are kept for merging along borders
+    std::vector<EquivalenceTable> tables(strips.size());
+    std::vector<std::vector<SegmentStats>> provisional(strips.size(), std::vector<SegmentStats>(1));
+    std::vector<RunLabelling> firstRows(strips.size()), lastRows(strips.size());
+    parallelForRows(0, stripsNumber, [&](int begin, int end){
+        for (int s = begin; s < end; ++s){
+            const unsigned int firstRow = static_cast<unsigned int>(strips[s].begin);
+            const unsigned int lastRow = static_cast<unsigned int>(strips[s].end - 1);
+            std::vector<SegmentStats>& stats = provisional[s];
+            RunLabelling& first = firstRows[s];
+            RunLabelling& last = lastRows[s];
+
+            scanRuns<Connectivity>(pixels, strips[s].begin, strips[s].end, tables[s], [&](const PixelRun& run, uint32_t label){
+                if (label >= stats.size()){
+                    stats.resize(label + 1);
+                }
+                stats[label].addRun(run);
+                if (run.row == firstRow){
+                    first.runs.emplace_back(run);
+                    first.labels.emplace_back(label);
+                }
+                if (run.row == lastRow){
+                    last.runs.emplace_back(run);
+                    last.labels.emplace_back(label);
+                }
+            });
+        }
+    });
+
+    std::vector<uint32_t> offsets;
+    ConcurrentEquivalenceTable table = joinStripTables(tables, offsets);
+
+    // runs of first row of strip are merged with overlapping runs of last row of previous strip
+    parallelForRows(1, stripsNumber, [&](int begin, int end){
+        for (int s = begin; s < end; ++s){
+            const RunLabelling& upper = lastRows[s - 1];
+            const RunLabelling& lower = firstRows[s];
+            size_t p = 0;
+            for (size_t i = 0; i < lower.runs.size(); ++i){
+                while (p < upper.runs.size() && upper.runs[p].colEnd + reach <= lower.runs[i].colStart){
+                    ++p;
+                }
+                for (size_t q = p; q < upper.runs.size() && upper.runs[q].colStart < lower.runs[i].colEnd + reach; ++q){
+                    table.merge(offsets[s - 1] + upper.labels[q], offsets[s] + lower.labels[i]);
+                }
+            }
+        }
+    });
+
+    std::vector<SegmentStats> result(table.flatten());
+    for (size_t s = 0; s < strips.size(); ++s){
+        for (uint32_t label = 1; label < provisional[s].size(); ++label){
+            result[table[offsets[s] + label] - 1].merge(provisional[s][label]);
+        }
+    }
+    for (size_t i = 0; i < result.size(); ++i){
+        result[i].id = static_cast<unsigned int>(i + 1);
+    }
+
+    return result;
+}
+
+#endif // LABELLING_HPP
@@ -7,13 +7,138 @@
 #include "utils.hpp"
 #include "segmentation.hpp"
 #include "moments.hpp"
+#include "parallel.hpp"
+#include "pipeline.hpp"
+#include "batch.hpp"
+#include "detection.hpp"
+#include "profiler.hpp"
 
 // std
 #include <random>
 #include <fstream>
+#include <cstring>
+#include <memory>
+#include <mutex>
 
 
-void proccessImage(std::string inputImg, std::string outputImg, int minSegSize, bool step_mode = false){
+/**
+ * @brief The DetectionFiles class - optional JSON Lines and CSV files with detections.
+ */
+class DetectionFiles{
+private:
+    std::ofstream jsonFile;
+    std::ofstream csvFile;
+    std::unique_ptr<DetectionWriter> jsonWriter;
+    std::unique_ptr<DetectionWriter> csvWriter;
+
+public:
+    /**
+     * @brief open Open files, empty name means that file is not written.
+     * @return False if any file can't be opened.
+     */
+    bool open(const std::string& jsonName, const std::string& csvName){
+        if (!jsonName.empty()){
+            jsonFile.open(jsonName, std::ios::out);
+            if (!jsonFile.is_open()){
+                return false;
+            }
+            jsonWriter.reset(new DetectionWriter(jsonFile, DetectionFormat::JSON_LINES));
+        }
+        if (!csvName.empty()){
+            csvFile.open(csvName, std::ios::out);
+            if (!csvFile.is_open()){
+                return false;
+            }
+            csvWriter.reset(new DetectionWriter(csvFile, DetectionFormat::CSV));
+        }
+        return true;
+    }
+
+    void write(const std::string& image, const std::vector<Detection>& detections){
+        if (jsonWriter){
+            jsonWriter->write(image, detections);
+        }
+        if (csvWriter){
+            csvWriter->write(image, detections);
+        }
+    }
+};
+
+/**
+ * @brief The ProfileFile class - optional file with JSON report of each image and summary
+ * of all images. Stages are measured only if program is built with LEGO_PROFILING.
+ */
+class ProfileFile{
+private:
+    std::ofstream file;
+    std::mutex mutex;
+    ProfileReport summary;
+
+public:
+    bool open(const std::string& name){
+        if (!name.empty()){
+            file.open(name, std::ios::out);
+            return file.is_open();
+        }
+        return true;
+    }
+
+    void write(const std::string& image, const ProfileReport& report){
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file.is_open()){
+            report.writeJSON(file, image);
+            file.flush();
+        }
+        summary.merge(report);
+    }
+
+    /**
+     * @brief writeSummary Write report of all images as last line.
+     */
+    void writeSummary(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file.is_open()){
+            summary.writeJSON(file, "summary");
+        }
+    }
+};
+
+/**
+ * @brief proccessImage Detect logos in image, write detections and optionally image with
+ * bounding rects. Filter and pixels picker work row by row, only pixels map is saved.
+ */
+void proccessImage(std::string inputImg, std::string outputImg, int minSegSize, bool writeImage,
+                   const MaskCleanup& cleanup, int connectivity, DetectionFiles& files, ProfileFile& profile){
+    ProfileReport report;
+    {
+        ProfileSession session(report);
+
+        cv::Mat orginal_img;
+        {
+            LEGO_PROFILE_STAGE("read_image", 0);
+            orginal_img = cv::imread(inputImg);
+        }
+
+        std::vector<Detection> detections = detectLegoWheels(orginal_img, minSegSize, cleanup, connectivity);
+        files.write(inputImg, detections);
+
+        if(writeImage){
+            drawDetections(orginal_img, detections);
+            LEGO_PROFILE_STAGE("write_image", orginal_img.total());
+            cv::imwrite(outputImg, orginal_img);
+        }
+    }
+    profile.write(inputImg, report);
+}
+
+/**
+ * @brief proccessImageStepMode Detect logos in image, result of each step is saved.
+ */
+void proccessImageStepMode(std::string inputImg, std::string outputImg, int minSegSize,
+                           const MaskCleanup& cleanup, int connectivity, DetectionFiles& files, ProfileFile& profile){
+    ProfileReport report;
+    ProfileSession session(report);
+
     // read image
     cv::Mat orginal_img = cv::imread(inputImg);
 
@@ -22,50 +147,86 @@ void proccessImage(std::string inputImg, std::string outputImg, int minSegSize,
                                     DEFUALT_RANK_FILTER_HEIGHT ,
                                     DEFAULT_RANK_FILTER_RANK);
     // save filter img
-    if(step_mode)
-        cv::imwrite("rank_filter_"+outputImg, filter_img);
+    cv::imwrite("rank_filter_"+outputImg, filter_img);
 
-    // convert image to Gimp HSV
-    auto res = cvtImgColorsToGIMPHSV(filter_img);
-
-    // chose pixels
-    auto pixels = neighbourAwarePixelPicker(res, FILTER_GIMP,
-                                            DEFUALT_PIX_CHOOSE_WIDTH,
-                                            DEFUALT_PIX_CHOOSE_HEIGHT,
-                                            DEFUALT_PIX_CHOOSE_PERCENT);
+    // chose pixels - colors are classified by lookup table compiled from GIMP HSV picker,
+    // so HSV image is not needed
+    PackedPixelsMap pixels = neighbourAwarePixelPicker(filter_img, gimpFilterLUT(),
+                                                       DEFUALT_PIX_CHOOSE_WIDTH,
+                                                       DEFUALT_PIX_CHOOSE_HEIGHT,
+                                                       DEFUALT_PIX_CHOOSE_PERCENT);
     // save pixels img
-    if(step_mode){
-        auto tmp = colorGivenPixelMap(filter_img, pixels);
-        cv::imwrite("pixels_"+outputImg, tmp);
+    auto tmp = colorGivenPixelMap(filter_img, pixels);
+    cv::imwrite("pixels_"+outputImg, tmp);
+
+    // clean pixels map
+    if(cleanup.enabled()){
+        pixels = cleanupMask(pixels, cleanup);
+        tmp = colorGivenPixelMap(filter_img, pixels);
+        cv::imwrite("cleaned_pixels_"+outputImg, tmp);
     }
 
-    // find segments
-    std::vector<Segment> segments = findSegments(pixels);
     // save segments img
-    if(step_mode){
-        auto tmp = filter_img.clone();
-        colorSegmentsWithRandomColor(tmp, segments);
-        cv::imwrite("segments_"+outputImg, tmp);
-    }
+    std::vector<RunSegment> runSegments = connectivity == 8 ? findRunSegments<8>(pixels) : findRunSegments<4>(pixels);
+    tmp = filter_img.clone();
+    colorSegmentsWithRandomColor(tmp, runSegments);
+    cv::imwrite("segments_"+outputImg, tmp);
 
-    std::vector<Segment> chosen = removeAdditionalSegments(minSegSize, segments);
-    // remove to small segments
-    if(step_mode){
-        auto tmp = filter_img.clone();
-        colorSegmentsWithRandomColor(tmp, chosen);
-        cv::imwrite("chosen_segments_"+outputImg, tmp);
-    }
+    tmp = filter_img.clone();
+    colorSegmentsWithRandomColor(tmp, removeAdditionalSegments(minSegSize, runSegments));
+    cv::imwrite("chosen_segments_"+outputImg, tmp);
 
-    // chose segments using moments
-    for(auto seg : chosen){
-        if (isValidSegment(seg)){
-            chosen.emplace_back(seg);
-            drawBoundingRectForSegment(orginal_img, seg);
-        }
-    }
+    // chose segments using size and moments
+    std::vector<Detection> detections = detectSegments(pixels, minSegSize, connectivity);
+    files.write(inputImg, detections);
 
+    drawDetections(orginal_img, detections);
     cv::imwrite(outputImg, orginal_img);
+    profile.write(inputImg, report);
+}
+
+/**
+ * @brief proccessBatch Detect logos in many images, failed images are printed and skipped.
+ */
+void proccessBatch(const std::string& input, const std::string& outputDir, int minSegSize,
+                   const MaskCleanup& cleanup, int connectivity, const BatchOptions& options, DetectionFiles& detectionFiles, ProfileFile& profile){
+    std::vector<std::string> files;
+    try {
+        files = collectInputFiles(input);
+    } catch (const std::exception& e) {
+        std::cout<<e.what()<<"\n";
+        return;
+    }
+
+    // compile lookup table before workers start
+    gimpFilterLUT();
+
+    size_t failed = 0;
+    try {
+        runBatch(files, outputDir, [minSegSize, &cleanup, connectivity, &options, &detectionFiles, &profile](const std::string& file, cv::Mat& img){
+            ProfileReport report;
+            {
+                ProfileSession session(report);
+                std::vector<Detection> detections = detectLegoWheels(img, minSegSize, cleanup, connectivity);
+                detectionFiles.write(file, detections);
+                if (options.writeImages){
+                    drawDetections(img, detections);
+                }
+            }
+            profile.write(file, report);
+        }, options, [&failed](const BatchResult& result){
+            if (!result.success){
+                ++failed;
+                std::cout<<"Failed: "<<result.inputFile<<" - "<<result.error<<"\n";
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cout<<e.what()<<"\n";
+        return;
+    }
 
+    profile.writeSummary();
+    std::cout<<"Processed "<<files.size() - failed<<" of "<<files.size()<<" images\n";
 }
 
 int main(int argc, char** argv)
@@ -73,27 +234,46 @@ int main(int argc, char** argv)
     // init random
     srand(time(nullptr));
 
+    // batch mode - first argument is '--batch'
+    bool batch_mode = argc > 1 && std::strcmp(argv[1], "--batch") == 0;
+    int first = batch_mode ? 2 : 1;
+
     // check if arguments number is correct
-    if(argc < 2 || argc > 5){
-        std::cout<<"Usage <input file> <output_file> <min segment size> <'--step' - optional: step mode>\n";
+    if(argc < first + 3){
+        std::cout<<"Usage <input file> <output_file> <min segment size> <'--step' - optional: step mode> "
+                   "<'--threads N' - optional: number of threads, 0 - all hardware threads> "
+                   "<'--json FILE' - optional: write detections to JSON Lines file> "
+                   "<'--csv FILE' - optional: write detections to CSV file> "
+                   "<'--no-image' - optional: don't write image with bounding rects> "
+                   "<'--profile FILE' - optional: write JSON report of stages, program must be built with LEGO_PROFILING> "
+                   "<'--open N' - optional: opening of pixels map with N x N window, N odd> "
+                   "<'--close N' - optional: closing of pixels map with N x N window, N odd> "
+                   "<'--connectivity N' - optional: 4 (default) or 8 connected segments>\n"
+                   "Batch mode: --batch <input directory, glob pattern or manifest file> <output directory> "
+                   "<min segment size> <'--workers N' - optional: number of images processed at once, 0 - all hardware threads> "
+                   "<'--queue N' - optional: number of images waiting for worker> "
+                   "<'--threads N' - optional: number of threads used by each image, default 1> "
+                   "<'--json FILE'> <'--csv FILE'> <'--no-image'> <'--profile FILE'> <'--open N'> <'--close N'> <'--connectivity N'>\n";
         return 0;
     }
 
     // load arguments
-    std::string input_file = argv[1];
-    std::string output_file = argv[2];
-    int min_segment_size = std::atoi(argv[3]);
+    std::string input_file = argv[first];
+    std::string output_file = argv[first + 1];
+    int min_segment_size = std::atoi(argv[first + 2]);
     bool step_mode = false;
 
-    // check file
-    std::fstream file;
-    file.open(input_file, std::ios_base::in);
-    if (!file.is_open()){
-        std::cout<<"Given file don't exist!\n";
+    // check file, in batch mode input can be glob pattern
+    if(!batch_mode){
+        std::fstream file;
+        file.open(input_file, std::ios_base::in);
+        if (!file.is_open()){
+            std::cout<<"Given file don't exist!\n";
+            file.close();
+            return 0;
+        }
         file.close();
-        return 0;
     }
-    file.close();
 
     // check segment min size
     if(min_segment_size<0){
@@ -101,13 +281,75 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    // check if program run in step mode
-    if(argc == 5 && std::strcmp(argv[4], "--step") == 0){
-        step_mode = true;
+    // check optional arguments, in batch mode images are processed in parallel,
+    // so by default each of them uses one thread
+    unsigned int threads = batch_mode ? 1 : 0;
+    BatchOptions options;
+    MaskCleanup cleanup;
+    int connectivity = 4;
+    std::string json_file, csv_file, profile_file;
+    for(int i = first + 3; i < argc; ++i){
+        bool has_number = i + 1 < argc && std::atoi(argv[i + 1]) >= 0;
+        if(std::strcmp(argv[i], "--step") == 0 && !batch_mode){
+            step_mode = true;
+        } else if(std::strcmp(argv[i], "--threads") == 0 && has_number){
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--workers") == 0 && has_number && batch_mode){
+            options.workers = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--queue") == 0 && has_number && batch_mode){
+            options.queueSize = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc){
+            json_file = argv[++i];
+        } else if(std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc){
+            csv_file = argv[++i];
+        } else if(std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            // without profiling report would be valid, but empty
+            if(!PROFILING_ENABLED){
+                std::cout<<"Program is built without LEGO_PROFILING, --profile can't be used!\n";
+                return 0;
+            }
+            profile_file = argv[++i];
+        } else if(std::strcmp(argv[i], "--open") == 0 && has_number && std::atoi(argv[i + 1]) % 2 == 1){
+            cleanup.openingSize = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--close") == 0 && has_number && std::atoi(argv[i + 1]) % 2 == 1){
+            cleanup.closingSize = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--connectivity") == 0 && i + 1 < argc &&
+                  (std::atoi(argv[i + 1]) == 4 || std::atoi(argv[i + 1]) == 8)){
+            connectivity = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--no-image") == 0){
+            options.writeImages = false;
+        } else {
+            std::cout<<"Unknown argument: "<<argv[i]<<"\n";
+            return 0;
+        }
+    }
+    // step mode shows every step on written images, so checked after all arguments
+    if(step_mode && !options.writeImages){
+        std::cout<<"Step mode writes images, it can't be used with --no-image!\n";
+        return 0;
     }
+    setThreadsNumber(threads);
 
-    // proccess image
-    proccessImage(input_file, output_file, min_segment_size, step_mode);
+    // open detections files
+    DetectionFiles detection_files;
+    if(!detection_files.open(json_file, csv_file)){
+        std::cout<<"Can't open detections file!\n";
+        return 0;
+    }
+    ProfileFile profile;
+    if(!profile.open(profile_file)){
+        std::cout<<"Can't open profile file!\n";
+        return 0;
+    }
+
+    // proccess images
+    if(batch_mode){
+        proccessBatch(input_file, output_file, min_segment_size, cleanup, connectivity, options, detection_files, profile);
+    } else if(step_mode){
+        proccessImageStepMode(input_file, output_file, min_segment_size, cleanup, connectivity, detection_files, profile);
+    } else {
+        proccessImage(input_file, output_file, min_segment_size, options.writeImages, cleanup, connectivity, detection_files, profile);
+    }
 
     // print the bluest quote ever
     std::cout<<BLUEST_QUOTE<<std::endl;
@@ -8,6 +8,10 @@
 // std
 #include<map>
 #include<string>
+#include<array>
+#include<vector>
+#include<fstream>
+#include<cmath>
 
 // opencv
 #include <opencv2/core/core.hpp>
@@ -21,31 +25,48 @@ using Moments = std::map<std::string, double>;
 
 
 /**
- * @brief getMoments Count moments for given segment.
- * @param seg Segment for which will be count moments.
- * @return Map of moments - key: name, value: moment value.
+ * @brief The HuMomentSet struct - ten invariant moments of segment in fixed array,
+ * each moment has named index, for example set[HuMomentSet::M1].
  */
-Moments getMoments(const Segment& seg)
-{
-    Moments moments;
+struct HuMomentSet{
+    // indices of moments, enum so they can be used as constant expressions and bound to references
+    enum Index : size_t {
+        M1 = 0, M2, M3, M4, M5, M6, M7, M8, M9, M10,
+        SIZE
+    };
+
+    std::array<double, SIZE> values;
 
-    double m00 = 0.0, m01 = 0.0, m10 = 0.0, m11 = 0.0, m20 = 0.0, m02 = 0.0, m21 = 0.0, m12 = 0.0, m30 = 0.0, m03 = 0.0;
-
-    for (auto pix : seg.pixels){
-        m00 += 1.0;
-        m10 += static_cast<double>(pix.second);
-        m01 += static_cast<double>(pix.first);
-        m11 += static_cast<double>(pix.first) * static_cast<double>(pix.second);
-        m20 += std::pow(static_cast<double>(pix.second), 2.0);
-        m02 += std::pow(static_cast<double>(pix.first), 2.0);
-        m21 += std::pow(static_cast<double>(pix.second), 2.0) * static_cast<double>(pix.first);
-        m12 += std::pow(static_cast<double>(pix.first), 2.0) * static_cast<double>(pix.second);
-        m30 += std::pow(static_cast<double>(pix.second), 3.0);
-        m03 += std::pow(static_cast<double>(pix.first), 3.0);
+    double& operator[](size_t index){
+        return values[index];
     }
 
+    double operator[](size_t index) const {
+        return values[index];
+    }
+
+    /**
+     * @brief name Name of moment with given index, the same as key in Moments map.
+     */
+    static const char* name(size_t index){
+        static const char* names[SIZE] = {"M1", "M2", "M3", "M4", "M5", "M6", "M7", "M8", "M9", "M10"};
+        return names[index];
+    }
+};
+
+/**
+ * @brief huMomentsFromRaw Count invariant moments from raw moments of segment.
+ * @param raw Raw moments.
+ * @return Set of moments.
+ */
+inline HuMomentSet huMomentsFromRaw(const RawMoments& raw)
+{
+    HuMomentSet moments;
+
+    const double m00 = raw.m00, m01 = raw.m01, m10 = raw.m10, m11 = raw.m11, m20 = raw.m20, m02 = raw.m02,
+            m21 = raw.m21, m12 = raw.m12, m30 = raw.m30, m03 = raw.m03;
+
     double xCent = m10 / m00, yCent = m01 / m00;
-    double M00 = m00, M01 = 0.0, M10 = 0.0;
     double M11 = m11 - m10 * m01 / m00;
     double M20 = m20 - std::pow(m10, 2.0) / m00;
     double M02 = m02 - std::pow(m01, 2.0) / m00;
@@ -54,78 +75,215 @@ Moments getMoments(const Segment& seg)
     double M30 = m30 - 3.0 * m20 * xCent + 2.0 * m10 * std::pow(xCent, 2.0);
     double M03 = m03 - 3.0 * m02 * yCent + 2.0 * m01 * std::pow(yCent, 2.0);
 
-    moments["M1"] = (M20 + M02) / std::pow(m00, 2.0);
-    moments["M2"] = (std::pow(M20 - M02, 2.0) + 4.0 * std::pow(M11, 2.0)) / std::pow(m00, 4.0);
-    moments["M3"] = (std::pow(M30 - 3.0 * M12, 2.0) + std::pow(3.0 * M21 - M03, 2.0)) / std::pow(m00, 5.0);
-    moments["M4"] = (std::pow(M30 + M12, 2.0) + std::pow(M21 + M03, 2.0)) / std::pow(m00, 5.0);
-    moments["M5"] = ((M30 - 3.0 * M12) * (M30 + M12) * (std::pow(M30 + M12, 2.0) - 3.0 * std::pow(M21 + M03, 2.0))
+    moments[HuMomentSet::M1] = (M20 + M02) / std::pow(m00, 2.0);
+    moments[HuMomentSet::M2] = (std::pow(M20 - M02, 2.0) + 4.0 * std::pow(M11, 2.0)) / std::pow(m00, 4.0);
+    moments[HuMomentSet::M3] = (std::pow(M30 - 3.0 * M12, 2.0) + std::pow(3.0 * M21 - M03, 2.0)) / std::pow(m00, 5.0);
+    moments[HuMomentSet::M4] = (std::pow(M30 + M12, 2.0) + std::pow(M21 + M03, 2.0)) / std::pow(m00, 5.0);
+    moments[HuMomentSet::M5] = ((M30 - 3.0 * M12) * (M30 + M12) * (std::pow(M30 + M12, 2.0) - 3.0 * std::pow(M21 + M03, 2.0))
         + (3.0 * M21 - M03) * (M21 + M03) * (3.0 * std::pow(M30 + M12, 2.0) - std::pow(M21 + M03, 2.0))) / std::pow(m00, 10.0);
-    moments["M6"] = ((M20 - M02) * (std::pow(M30 + M12, 2.0) - std::pow(M21 + M03, 2.0)) + 4.0 * M11 * (M30 + M12) * (M21 + M03)) / std::pow(m00, 7.0);
-    moments["M7"] = (M20 * M02 - std::pow(M11, 2.0)) / std::pow(m00, 4.0);
-    moments["M8"] = (M30 * M12 + M21 * M03 - std::pow(M12, 2.0) - std::pow(M21, 2.0)) / std::pow(m00, 5.0);
-    moments["M9"] = (M20 * (M21 * M03 - std::pow(M12, 2.0)) + M02 * (M03 * M12 - std::pow(M21, 2.0)) - M11 * (M30 * M03 - M21 * M12)) / std::pow(m00, 7.0);
-    moments["M10"] = (std::pow(M30 * M03 - M12 * M21, 2.0) - 4.0 * (M30 * M12 - std::pow(M21, 2)) * (M03 * M21 - M12)) / std::pow(m00, 10.0);
+    moments[HuMomentSet::M6] = ((M20 - M02) * (std::pow(M30 + M12, 2.0) - std::pow(M21 + M03, 2.0)) + 4.0 * M11 * (M30 + M12) * (M21 + M03)) / std::pow(m00, 7.0);
+    moments[HuMomentSet::M7] = (M20 * M02 - std::pow(M11, 2.0)) / std::pow(m00, 4.0);
+    moments[HuMomentSet::M8] = (M30 * M12 + M21 * M03 - std::pow(M12, 2.0) - std::pow(M21, 2.0)) / std::pow(m00, 5.0);
+    moments[HuMomentSet::M9] = (M20 * (M21 * M03 - std::pow(M12, 2.0)) + M02 * (M03 * M12 - std::pow(M21, 2.0)) - M11 * (M30 * M03 - M21 * M12)) / std::pow(m00, 7.0);
+    moments[HuMomentSet::M10] = (std::pow(M30 * M03 - M12 * M21, 2.0) - 4.0 * (M30 * M12 - std::pow(M21, 2)) * (M03 * M21 - M12)) / std::pow(m00, 10.0);
+
+    return moments;
+}
+
+/**
+ * @brief getHuMoments Count moments for given segment.
+ * @param seg Segment for which will be count moments.
+ * @return Set of moments.
+ */
+inline HuMomentSet getHuMoments(const Segment& seg)
+{
+    RawMoments raw;
+    for (auto& pix : seg.pixels){
+        raw.addPixel(pix.first, pix.second);
+    }
+    return huMomentsFromRaw(raw);
+}
+
+/**
+ * @brief getHuMoments Count moments for given run length segment.
+ * @param seg Segment for which will be count moments.
+ * @return Set of moments.
+ */
+inline HuMomentSet getHuMoments(const RunSegment& seg)
+{
+    RawMoments raw;
+    for (auto& run : seg.runs){
+        raw.addRun(run);
+    }
+    return huMomentsFromRaw(raw);
+}
 
+/**
+ * @brief getHuMoments Count moments from segment statistics.
+ * @param seg Statistics of segment for which will be count moments.
+ * @return Set of moments.
+ */
+inline HuMomentSet getHuMoments(const SegmentStats& seg)
+{
+    return huMomentsFromRaw(seg.moments);
+}
+
+/**
+ * @brief toMomentsMap Convert set of moments to map, kept for compatibility.
+ * @param set Set of moments.
+ * @return Map of moments - key: name, value: moment value.
+ */
+inline Moments toMomentsMap(const HuMomentSet& set){
+    Moments moments;
+    for (size_t i = 0; i < HuMomentSet::SIZE; ++i){
+        moments[HuMomentSet::name(i)] = set[i];
+    }
     return moments;
 }
 
+/**
+ * @brief fromMomentsMap Convert map of moments to set, missing moments are 0.
+ * @param moments Map of moments - key: name, value: moment value.
+ * @return Set of moments.
+ */
+inline HuMomentSet fromMomentsMap(const Moments& moments){
+    HuMomentSet set;
+    for (size_t i = 0; i < HuMomentSet::SIZE; ++i){
+        auto it = moments.find(HuMomentSet::name(i));
+        set[i] = it == moments.end() ? 0.0 : it->second;
+    }
+    return set;
+}
+
+/**
+ * @brief momentsFromRaw Count moments from raw moments of segment.
+ * @param raw Raw moments.
+ * @return Map of moments - key: name, value: moment value.
+ */
+inline Moments momentsFromRaw(const RawMoments& raw)
+{
+    return toMomentsMap(huMomentsFromRaw(raw));
+}
+
+/**
+ * @brief getMoments Count moments for given segment.
+ * @param seg Segment for which will be count moments.
+ * @return Map of moments - key: name, value: moment value.
+ */
+inline Moments getMoments(const Segment& seg)
+{
+    return toMomentsMap(getHuMoments(seg));
+}
+
+/**
+ * @brief getMoments Count moments for given run length segment.
+ * @param seg Segment for which will be count moments.
+ * @return Map of moments - key: name, value: moment value.
+ */
+inline Moments getMoments(const RunSegment& seg)
+{
+    return toMomentsMap(getHuMoments(seg));
+}
+
+/**
+ * @brief getMoments Count moments from segment statistics.
+ * @param seg Statistics of segment for which will be count moments.
+ * @return Map of moments - key: name, value: moment value.
+ */
+inline Moments getMoments(const SegmentStats& seg)
+{
+    return toMomentsMap(getHuMoments(seg));
+}
+
 /**
  * @brief saveMomentsToCSV Simple function that saves moments from given vector to csv file.
  * @param moments Vector fo moments to save.
  * @param csvName Name of csv file.
  */
-void saveMomentsToCSV(std::vector<Moments>& moments, std::string csvName = "moments.csv"){
+inline void saveMomentsToCSV(const std::vector<HuMomentSet>& moments, std::string csvName = "moments.csv"){
     std::fstream file(csvName, std::ios::out);
 
     // iterate over vector moments
-    for ( auto& m : moments){
-        file<<float(m["M1"])<<";";
-        file<<float(m["M2"])<<";";
-        file<<float(m["M3"])<<";";
-        file<<float(m["M4"])<<";";
-        file<<float(m["M5"])<<";";
-        file<<float(m["M6"])<<";";
-        file<<float(m["M7"])<<";";
-        file<<float(m["M8"])<<";";
-        file<<float(m["M9"])<<";";
-        file<<float(m["M10"]);
-        file<<"\n";
+    for (auto& m : moments){
+        for (size_t i = 0; i < HuMomentSet::SIZE; ++i){
+            file<<float(m[i]);
+            file<<(i + 1 < HuMomentSet::SIZE ? ";" : "\n");
+        }
     }
 
     file.close();
 }
 
 /**
- * @brief isValidSegment Check if given segment is a valid Lego wheel.
- * @param seg Segment which will be check using moments.
- * @return True if it is a wheel like object, false otherwise.
+ * @brief saveMomentsToCSV Simple function that saves moments from given vector of maps to csv file.
+ * @param moments Vector fo moments to save.
+ * @param csvName Name of csv file.
  */
-bool isValidSegment(Segment& seg){
-    auto moments = getMoments(seg);
+inline void saveMomentsToCSV(const std::vector<Moments>& moments, std::string csvName = "moments.csv"){
+    std::vector<HuMomentSet> sets;
+    for (auto& m : moments){
+        sets.emplace_back(fromMomentsMap(m));
+    }
+    saveMomentsToCSV(sets, csvName);
+}
 
-    if (moments["M1"] > 0.2 || moments["M1"]< 0.15)
+/**
+ * @brief isValidMoments Check if given moments describe a valid Lego wheel.
+ * @param moments Moments of segment.
+ * @return True if it is a wheel like object, false otherwise.
+ */
+inline bool isValidMoments(const HuMomentSet& moments){
+    if (moments[HuMomentSet::M1] > 0.2 || moments[HuMomentSet::M1]< 0.15)
         return false;
 
-    if (moments["M2"] > 0.002)
+    if (moments[HuMomentSet::M2] > 0.002)
         return false;
 
-    if (moments["M3"] > 0.001)
+    if (moments[HuMomentSet::M3] > 0.001)
         return false;
 
-    if (moments["M7"] > 0.1 || moments["M9"] <-0.01){
+    if (moments[HuMomentSet::M7] > 0.1 || moments[HuMomentSet::M9] <-0.01){
         return false;
     }
 
-    if (moments["M8"] > 0.002){
+    if (moments[HuMomentSet::M8] > 0.002){
         return false;
     }
 
-    if (moments["M9"] > 0.0005 || moments["M9"] <-0.0005){
+    if (moments[HuMomentSet::M9] > 0.0005 || moments[HuMomentSet::M9] <-0.0005){
         return false;
     }
 
     return true;
 }
 
+/**
+ * @brief isValidSegment Check if given segment is a valid Lego wheel.
+ * @param seg Segment which will be check using moments.
+ * @return True if it is a wheel like object, false otherwise.
+ */
+inline bool isValidSegment(const Segment& seg){
+    return isValidMoments(getHuMoments(seg));
+}
+
+/**
+ * @brief isValidSegment Check if given segment is a valid Lego wheel.
+ * @param seg Run length segment which will be check using moments.
+ * @return True if it is a wheel like object, false otherwise.
+ */
+inline bool isValidSegment(const RunSegment& seg){
+    return isValidMoments(getHuMoments(seg));
+}
+
+/**
+ * @brief isValidSegment Check if given segment is a valid Lego wheel using only its statistics.
+ * @param seg Segment statistics.
+ * @return True if it is a wheel like object, false otherwise.
+ */
+inline bool isValidSegment(const SegmentStats& seg){
+    return isValidMoments(getHuMoments(seg));
+}
+
+
 
 #endif // MOMENTS_HPP
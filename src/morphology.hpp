@@ -0,0 +1,438 @@
+/**
+  * Morphology on packed pixels maps and byte masks. Structuring element is rectangle and filter
+  * is separable. Packed rows are processed as 64 bit words - horizontal pass ORs (dilation) or
+  * ANDs (erosion) shifted copies of row, window of width w is built from log2(w) doubled windows.
+  * Vertical pass and both passes on byte masks use van Herk/Gil-Werman algorithm - line is split
+  * into blocks of window size, prefix and suffix of each block are counted, then each window is
+  * suffix of one block and prefix of next one. It takes 3 operations per pixel whatever window size.
+  * Pixels closer to border than half of window keep their value, the same as in closing and
+  * opening from utils.hpp.
+  */
+
+#ifndef MORPHOLOGY_HPP
+#define MORPHOLOGY_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+
+// std
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+// lego
+#include "packed_pixels_map.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+/**
+ * @brief The MorphologyOp enum - basic morphology operation.
+ * DILATE - pixel is chosen if any pixel in window is chosen.
+ * ERODE - pixel is chosen if all pixels in window are chosen.
+ */
+enum class MorphologyOp{
+    DILATE,
+    ERODE
+};
+
+/**
+ * @brief checkMorphologyWindow Check if window size is not negative and odd.
+ */
+inline void checkMorphologyWindow(int width, int height){
+    if (width < 0 || height < 0){
+        throw std::runtime_error("Filter size is negative!");
+    } else if (width % 2 == 0 || height % 2 == 0){
+        throw std::runtime_error("Filter size not odd!");
+    }
+}
+
+/**
+ * @brief rowBitsAt Take 64 bits of row starting at given bit, bits outside of row are 0.
+ * @param row Words of row.
+ * @param words Number of words in row.
+ * @param pos First bit, can be negative.
+ * @return Bit k of result is bit pos + k of row.
+ */
+inline uint64_t rowBitsAt(const uint64_t* row, long words, long pos){
+    const int WORD_BITS = PackedPixelsMap::WORD_BITS;
+    long w = pos >= 0 ? pos / WORD_BITS : -((-pos + WORD_BITS - 1) / WORD_BITS);
+    int b = static_cast<int>(pos - w * WORD_BITS);
+
+    uint64_t low = (w >= 0 && w < words) ? row[w] : 0;
+    if (b == 0){
+        return low;
+    }
+    uint64_t high = (w + 1 >= 0 && w + 1 < words) ? row[w + 1] : 0;
+    return (low >> b) | (high << (WORD_BITS - b));
+}
+
+/**
+ * @brief morphologyRow Horizontal pass - OR or AND of width neighbours of each pixel, window
+ * is centered at pixel. Windows of length 2L are built from two windows of length L.
+ * @param src Words of source row.
+ * @param words Number of words in row.
+ * @param width Width of window, odd.
+ * @param op Operation.
+ * @param tmp Buffer of words words.
+ * @param dst Words of result row, pixels closer to row end than width / 2 are undefined.
+ */
+inline void morphologyRow(const uint64_t* src, long words, int width, MorphologyOp op, uint64_t* tmp, uint64_t* dst){
+    const int WORD_BITS = PackedPixelsMap::WORD_BITS;
+    const bool dilate = op == MorphologyOp::DILATE;
+    std::copy(src, src + words, tmp);
+
+    // tmp bit c is OR / AND of bits [c, c + length), words are read only forward, so it can be done in place
+    int length = 1;
+    while (length * 2 <= width){
+        for (long i = 0; i < words; ++i){
+            uint64_t shifted = rowBitsAt(tmp, words, i * WORD_BITS + length);
+            tmp[i] = dilate ? (tmp[i] | shifted) : (tmp[i] & shifted);
+        }
+        length *= 2;
+    }
+    if (length < width){
+        for (long i = 0; i < words; ++i){
+            uint64_t shifted = rowBitsAt(tmp, words, i * WORD_BITS + width - length);
+            tmp[i] = dilate ? (tmp[i] | shifted) : (tmp[i] & shifted);
+        }
+    }
+
+    // window of pixel c starts at c - width / 2
+    for (long i = 0; i < words; ++i){
+        dst[i] = rowBitsAt(tmp, words, i * WORD_BITS - width / 2);
+    }
+}
+
+/**
+ * @brief vanHerkBlock Count prefixes and suffixes of one block of rows [first, last].
+ */
+template <typename T, typename Op>
+void vanHerkBlock(const T* src, size_t stride, int first, int last, size_t n, Op op, T* prefix, T* suffix){
+    std::copy(src + first * stride, src + first * stride + n, prefix + first * stride);
+    for (int r = first + 1; r <= last; ++r){
+        const T* in = src + r * stride;
+        const T* previous = prefix + (r - 1) * stride;
+        T* out = prefix + r * stride;
+        for (size_t i = 0; i < n; ++i){
+            out[i] = op(previous[i], in[i]);
+        }
+    }
+
+    std::copy(src + last * stride, src + last * stride + n, suffix + last * stride);
+    for (int r = last - 1; r >= first; --r){
+        const T* in = src + r * stride;
+        const T* next = suffix + (r + 1) * stride;
+        T* out = suffix + r * stride;
+        for (size_t i = 0; i < n; ++i){
+            out[i] = op(next[i], in[i]);
+        }
+    }
+}
+
+/**
+ * @brief vanHerkBlocks Count prefixes and suffixes of blocks of rows for van Herk/Gil-Werman
+ * vertical pass. Blocks are [k * size, (k + 1) * size), blocks are counted in parallel.
+ * @param src Source rows, row r starts at src + r * stride.
+ * @param stride Number of elements between rows.
+ * @param rows Number of rows.
+ * @param n Number of elements in row.
+ * @param size Window size, block size.
+ * @param op Operation, OR / AND for words or max / min for bytes.
+ * @param prefix Result - op of rows from block start to row, the same layout as src.
+ * @param suffix Result - op of rows from row to block end, the same layout as src.
+ */
+template <typename T, typename Op>
+void vanHerkBlocks(const T* src, size_t stride, int rows, size_t n, int size, Op op, T* prefix, T* suffix){
+    const int blocks = (rows + size - 1) / size;
+
+    parallelForRows(0, blocks, [&](int begin, int end){
+        for (int b = begin; b < end; ++b){
+            const int first = b * size;
+            vanHerkBlock(src, stride, first, std::min(rows, first + size) - 1, n, op, prefix, suffix);
+        }
+    });
+}
+
+/**
+ * @brief vanHerkLine Van Herk/Gil-Werman filter of one line, window is centered at element.
+ * @param src Source line.
+ * @param n Number of elements.
+ * @param size Window size, odd.
+ * @param op Operation.
+ * @param prefix Buffer of n elements.
+ * @param suffix Buffer of n elements.
+ * @param dst Result line, only elements [size / 2, n - size / 2) are written.
+ */
+template <typename T, typename Op>
+void vanHerkLine(const T* src, int n, int size, Op op, T* prefix, T* suffix, T* dst){
+    for (int first = 0; first < n; first += size){
+        const int last = std::min(n, first + size) - 1;
+        prefix[first] = src[first];
+        for (int x = first + 1; x <= last; ++x){
+            prefix[x] = op(prefix[x - 1], src[x]);
+        }
+        suffix[last] = src[last];
+        for (int x = last - 1; x >= first; --x){
+            suffix[x] = op(suffix[x + 1], src[x]);
+        }
+    }
+
+    const int half = size / 2;
+    for (int x = half; x < n - half; ++x){
+        dst[x] = op(suffix[x - half], prefix[x + half]);
+    }
+}
+
+/**
+ * @brief morphology Dilation or erosion by rectangle, pixels closer to border than half of
+ * window keep their value.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @param op Operation.
+ * @return Result map.
+ */
+inline PackedPixelsMap morphology(const PackedPixelsMap& pixMap, int width, int height, MorphologyOp op){
+    checkMorphologyWindow(width, height);
+
+    const int rows = pixMap.rows(), cols = pixMap.cols();
+    const int halfW = width / 2, halfH = height / 2;
+    const long words = static_cast<long>(pixMap.wordsInRow());
+    const bool dilate = op == MorphologyOp::DILATE;
+
+    PackedPixelsMap result(pixMap);
+    if (rows < height || cols < width){
+        return result;
+    }
+
+    // columns [halfW, cols - halfW) are counted, others are copied
+    std::vector<uint64_t> interior(words, 0);
+    for (long i = 0; i < words; ++i){
+        for (int b = 0; b < PackedPixelsMap::WORD_BITS; ++b){
+            long col = i * PackedPixelsMap::WORD_BITS + b;
+            if (col >= halfW && col < cols - halfW){
+                interior[i] |= uint64_t(1) << b;
+            }
+        }
+    }
+
+    // horizontal pass of each row
+    PackedPixelsMap horizontal(rows, cols);
+    parallelForRows(0, rows, [&](int begin, int end){
+        std::vector<uint64_t> tmp(words);
+        for (int r = begin; r < end; ++r){
+            morphologyRow(pixMap.row(r), words, width, op, tmp.data(), horizontal.row(r));
+        }
+    });
+
+    // vertical pass - window of row r is suffix of row r - halfH and prefix of row r + halfH
+    PackedPixelsMap prefix(rows, cols), suffix(rows, cols);
+    auto combine = [dilate](uint64_t a, uint64_t b){ return dilate ? (a | b) : (a & b); };
+    vanHerkBlocks(horizontal.row(0), horizontal.stride(), rows, static_cast<size_t>(words), height,
+                  combine, prefix.row(0), suffix.row(0));
+
+    parallelForRows(halfH, rows - halfH, [&](int begin, int end){
+        for (int r = begin; r < end; ++r){
+            uint64_t* dst = result.row(r);
+            const uint64_t* src = pixMap.row(r);
+            const uint64_t* top = suffix.row(r - halfH);
+            const uint64_t* bottom = prefix.row(r + halfH);
+            for (long i = 0; i < words; ++i){
+                dst[i] = (combine(top[i], bottom[i]) & interior[i]) | (src[i] & ~interior[i]);
+            }
+        }
+    });
+
+    return result;
+}
+
+/**
+ * @brief checkMask Check if image is one channel 8 bit mask.
+ */
+inline void checkMask(const cv::Mat& mask){
+    if (mask.type() != CV_8UC1){
+        throw std::runtime_error("Mask is not one channel 8 bit image!");
+    }
+}
+
+/**
+ * @brief The MaxOp / MinOp structs - operations of byte mask dilation and erosion, known at
+ * compile time so loops of van Herk/Gil-Werman passes are vectorized.
+ */
+struct MaxOp{
+    uint8_t operator()(uint8_t a, uint8_t b) const { return a > b ? a : b; }
+};
+
+struct MinOp{
+    uint8_t operator()(uint8_t a, uint8_t b) const { return a < b ? a : b; }
+};
+
+/**
+ * @brief maskMorphology Van Herk/Gil-Werman filter of byte mask with given operation, see below.
+ */
+template <typename Op>
+cv::Mat maskMorphology(const cv::Mat& mask, int width, int height, Op combine){
+    const int rows = mask.rows, cols = mask.cols;
+    const int halfW = width / 2, halfH = height / 2;
+
+    cv::Mat result = mask.clone();
+    if (rows < height || cols < width){
+        return result;
+    }
+
+    // horizontal pass, border columns are copied
+    std::vector<uint8_t> horizontal(static_cast<size_t>(rows) * cols);
+    parallelForRows(0, rows, [&](int begin, int end){
+        std::vector<uint8_t> prefix(cols), suffix(cols);
+        for (int r = begin; r < end; ++r){
+            const uint8_t* src = mask.ptr<uint8_t>(r);
+            uint8_t* dst = &horizontal[static_cast<size_t>(r) * cols];
+            vanHerkLine(src, cols, width, combine, prefix.data(), suffix.data(), dst);
+            std::copy(src, src + halfW, dst);
+            std::copy(src + cols - halfW, src + cols, dst + cols - halfW);
+        }
+    });
+
+    // vertical pass, border rows stay as in source
+    std::vector<uint8_t> prefix(horizontal.size()), suffix(horizontal.size());
+    vanHerkBlocks(horizontal.data(), static_cast<size_t>(cols), rows, static_cast<size_t>(cols), height,
+                  combine, prefix.data(), suffix.data());
+
+    parallelForRows(halfH, rows - halfH, [&](int begin, int end){
+        const int first = halfW;
+        for (int r = begin; r < end; ++r){
+            uint8_t* dst = result.ptr<uint8_t>(r);
+            const uint8_t* top = &suffix[static_cast<size_t>(r - halfH) * cols];
+            const uint8_t* bottom = &prefix[static_cast<size_t>(r + halfH) * cols];
+            for (int j = first, last = cols - halfW; j < last; ++j){
+                dst[j] = combine(top[j], bottom[j]);
+            }
+        }
+    });
+
+    return result;
+}
+
+/**
+ * @brief maskMorphology Max (dilation) or min (erosion) filter of byte mask by rectangle, both
+ * passes use van Herk/Gil-Werman algorithm. Pixels closer to border than half of window keep
+ * their value.
+ * @param mask One channel CV_8UC1 mask.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @param op Operation.
+ * @return Result mask.
+ */
+inline cv::Mat maskMorphology(const cv::Mat& mask, int width, int height, MorphologyOp op){
+    checkMorphologyWindow(width, height);
+    checkMask(mask);
+
+    if (op == MorphologyOp::DILATE){
+        return maskMorphology(mask, width, height, MaxOp());
+    }
+    return maskMorphology(mask, width, height, MinOp());
+}
+
+/**
+ * @brief dilateMask Max filter of byte mask, for 0 / 1 masks the same as dilation of pixels map.
+ * @param mask One channel CV_8UC1 mask.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result mask.
+ */
+inline cv::Mat dilateMask(const cv::Mat& mask, int width, int height){
+    return maskMorphology(mask, width, height, MorphologyOp::DILATE);
+}
+
+/**
+ * @brief erodeMask Min filter of byte mask, for 0 / 1 masks the same as erosion of pixels map.
+ * @param mask One channel CV_8UC1 mask.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result mask.
+ */
+inline cv::Mat erodeMask(const cv::Mat& mask, int width, int height){
+    return maskMorphology(mask, width, height, MorphologyOp::ERODE);
+}
+
+/**
+ * @brief dilation Pixel is chosen if any pixel in its window is chosen. Result is the same
+ * as from closing in utils.hpp.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
+ */
+inline PackedPixelsMap dilation(const PackedPixelsMap& pixMap, int width, int height){
+    return morphology(pixMap, width, height, MorphologyOp::DILATE);
+}
+
+/**
+ * @brief erosion Pixel is chosen if all pixels in its window are chosen. Result is the same
+ * as from opening in utils.hpp.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
+ */
+inline PackedPixelsMap erosion(const PackedPixelsMap& pixMap, int width, int height){
+    return morphology(pixMap, width, height, MorphologyOp::ERODE);
+}
+
+/**
+ * @brief morphologicalOpening Erosion and then dilation - removes segments and parts of
+ * segments smaller than window.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
+ */
+inline PackedPixelsMap morphologicalOpening(const PackedPixelsMap& pixMap, int width, int height){
+    return dilation(erosion(pixMap, width, height), width, height);
+}
+
+/**
+ * @brief morphologicalClosing Dilation and then erosion - fills holes and gaps smaller than window.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
+ */
+inline PackedPixelsMap morphologicalClosing(const PackedPixelsMap& pixMap, int width, int height){
+    return erosion(dilation(pixMap, width, height), width, height);
+}
+
+/**
+ * @brief The MaskCleanup struct - optional cleanup of pixels map before segmentation.
+ * openingSize - size of square window of opening, removes noise, 0 - no opening.
+ * closingSize - size of square window of closing, fills holes, 0 - no closing.
+ */
+struct MaskCleanup{
+    int openingSize = 0;
+    int closingSize = 0;
+
+    bool enabled() const {
+        return openingSize > 0 || closingSize > 0;
+    }
+};
+
+/**
+ * @brief cleanupMask Opening and then closing of pixels map, operations with size 0 are skipped.
+ * @param pixMap Map of chosen pixels.
+ * @param cleanup Sizes of windows.
+ * @return Result map.
+ */
+inline PackedPixelsMap cleanupMask(const PackedPixelsMap& pixMap, const MaskCleanup& cleanup){
+    LEGO_PROFILE_STAGE("mask_cleanup", static_cast<size_t>(pixMap.rows()) * pixMap.cols());
+    PackedPixelsMap result = pixMap;
+    if (cleanup.openingSize > 0){
+        result = morphologicalOpening(result, cleanup.openingSize, cleanup.openingSize);
+    }
+    if (cleanup.closingSize > 0){
+        result = morphologicalClosing(result, cleanup.closingSize, cleanup.closingSize);
+    }
+    return result;
+}
+
+#endif // MORPHOLOGY_HPP
@@ -0,0 +1,242 @@
+/**
+  * Header file for PackedPixelsMap class - bit packed map of chosen pixels.
+  */
+
+#ifndef PACKED_PIXELS_MAP_HPP
+#define PACKED_PIXELS_MAP_HPP
+
+// std
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// legacy pixels map - vector of rows
+using PixelsMap = std::vector<std::vector<bool>>;
+
+/**
+ * @class PackedPixelsMap
+ * @brief The PackedPixelsMap class - map of chosen pixels, one bit per pixel. All rows are
+ * kept in one allocation, each row starts at 64 byte boundary and is stored as 64 bit words,
+ * pixel in column c is bit (c % 64) of word (c / 64). Bits after last column are always 0,
+ * so words can be processed without masking. It can be created from and converted
+ * to PixelsMap.
+ */
+class PackedPixelsMap{
+public:
+    static const int WORD_BITS = 64;
+    static const size_t ALIGNMENT = 64;
+
+    /**
+     * @brief The RowView class - read only view of one row, let use map[row][col].
+     */
+    class RowView{
+    private:
+        const uint64_t* words;
+        int colsNumber;
+
+    public:
+        RowView(const uint64_t* words, int colsNumber) : words(words), colsNumber(colsNumber) {}
+
+        bool operator[](int col) const {
+            return (words[col / WORD_BITS] >> (col % WORD_BITS)) & 1u;
+        }
+
+        size_t size() const {
+            return static_cast<size_t>(colsNumber);
+        }
+    };
+
+private:
+    int rowsNumber;
+    int colsNumber;
+    size_t wordsPerRow;
+    std::unique_ptr<uint8_t[]> storage;
+    uint64_t* words;
+
+    void allocate(int rows, int cols){
+        rowsNumber = std::max(rows, 0);
+        colsNumber = std::max(cols, 0);
+
+        // round row to whole cache line
+        const size_t wordsPerLine = ALIGNMENT / sizeof(uint64_t);
+        wordsPerRow = (static_cast<size_t>(colsNumber) + WORD_BITS - 1) / WORD_BITS;
+        wordsPerRow = (wordsPerRow + wordsPerLine - 1) / wordsPerLine * wordsPerLine;
+
+        // map without pixels has no storage, the same as empty map
+        const size_t bytes = wordsPerRow * rowsNumber * sizeof(uint64_t);
+        if (bytes == 0){
+            storage.reset();
+            words = nullptr;
+            return;
+        }
+        storage.reset(new uint8_t[bytes + ALIGNMENT]);
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+        words = reinterpret_cast<uint64_t*>((address + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1));
+        std::fill(words, words + wordsPerRow * rowsNumber, 0);
+    }
+
+    // empty map without storage, so empty and moved from maps never allocate
+    void release() noexcept{
+        rowsNumber = 0;
+        colsNumber = 0;
+        wordsPerRow = 0;
+        storage.reset();
+        words = nullptr;
+    }
+
+public:
+    PackedPixelsMap() noexcept{
+        release();
+    }
+
+    /**
+     * @brief PackedPixelsMap Create map with all pixels not chosen.
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     */
+    PackedPixelsMap(int rows, int cols){
+        allocate(rows, cols);
+    }
+
+    /**
+     * @brief PackedPixelsMap Create map from legacy PixelsMap, all rows should have the same size.
+     * @param pixelsMap Legacy pixels map.
+     */
+    PackedPixelsMap(const PixelsMap& pixelsMap){
+        allocate(static_cast<int>(pixelsMap.size()), pixelsMap.empty() ? 0 : static_cast<int>(pixelsMap[0].size()));
+        for (int i = 0; i < rowsNumber; ++i){
+            for (int j = 0; j < colsNumber && j < static_cast<int>(pixelsMap[i].size()); ++j){
+                if (pixelsMap[i][j]){
+                    set(i, j, true);
+                }
+            }
+        }
+    }
+
+    PackedPixelsMap(const PackedPixelsMap& other){
+        allocate(other.rowsNumber, other.colsNumber);
+        std::copy(other.words, other.words + wordsPerRow * rowsNumber, words);
+    }
+
+    PackedPixelsMap(PackedPixelsMap&& other) noexcept
+        : rowsNumber(other.rowsNumber), colsNumber(other.colsNumber), wordsPerRow(other.wordsPerRow),
+          storage(std::move(other.storage)), words(other.words) {
+        other.release();
+    }
+
+    PackedPixelsMap& operator=(const PackedPixelsMap& other){
+        if (this != &other){
+            allocate(other.rowsNumber, other.colsNumber);
+            std::copy(other.words, other.words + wordsPerRow * rowsNumber, words);
+        }
+        return *this;
+    }
+
+    PackedPixelsMap& operator=(PackedPixelsMap&& other) noexcept{
+        if (this != &other){
+            rowsNumber = other.rowsNumber;
+            colsNumber = other.colsNumber;
+            wordsPerRow = other.wordsPerRow;
+            storage = std::move(other.storage);
+            words = other.words;
+            other.release();
+        }
+        return *this;
+    }
+
+    int rows() const {
+        return rowsNumber;
+    }
+
+    int cols() const {
+        return colsNumber;
+    }
+
+    /**
+     * @brief stride Number of 64 bit words in each row, including padding.
+     */
+    size_t stride() const {
+        return wordsPerRow;
+    }
+
+    /**
+     * @brief wordsInRow Number of 64 bit words that contain pixels of row.
+     */
+    size_t wordsInRow() const {
+        return (static_cast<size_t>(colsNumber) + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    uint64_t* row(int i){
+        return words + wordsPerRow * i;
+    }
+
+    const uint64_t* row(int i) const {
+        return words + wordsPerRow * i;
+    }
+
+    bool get(int row, int col) const {
+        return (words[wordsPerRow * row + col / WORD_BITS] >> (col % WORD_BITS)) & 1u;
+    }
+
+    void set(int row, int col, bool value){
+        uint64_t& word = words[wordsPerRow * row + col / WORD_BITS];
+        uint64_t bit = uint64_t(1) << (col % WORD_BITS);
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    /**
+     * @brief count Count chosen pixels.
+     */
+    size_t count() const {
+        size_t result = 0;
+        for (size_t i = 0; i < wordsPerRow * rowsNumber; ++i){
+            result += static_cast<size_t>(__builtin_popcountll(words[i]));
+        }
+        return result;
+    }
+
+    /**
+     * @brief toPixelsMap Convert to legacy PixelsMap.
+     */
+    PixelsMap toPixelsMap() const {
+        PixelsMap result(rowsNumber, std::vector<bool>(colsNumber, false));
+        for (int i = 0; i < rowsNumber; ++i){
+            for (int j = 0; j < colsNumber; ++j){
+                result[i][j] = get(i, j);
+            }
+        }
+        return result;
+    }
+
+    operator PixelsMap() const {
+        return toPixelsMap();
+    }
+
+    // legacy PixelsMap like access
+    RowView operator[](int row) const {
+        return RowView(this->row(row), colsNumber);
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(rowsNumber);
+    }
+
+    bool empty() const {
+        return rowsNumber == 0;
+    }
+
+    bool operator==(const PackedPixelsMap& other) const {
+        if (rowsNumber != other.rowsNumber || colsNumber != other.colsNumber){
+            return false;
+        }
+        return std::equal(words, words + wordsPerRow * rowsNumber, other.words);
+    }
+
+    bool operator!=(const PackedPixelsMap& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif // PACKED_PIXELS_MAP_HPP
@@ -0,0 +1,259 @@
+/**
+  * Simple thread pool and row bands parallel execution used by per pixel stages.
+  * Each band of rows is processed by one task and writes only its own rows of result,
+  * so result doesn't depend on number of threads.
+  */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+// std
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+// minimal number of rows in band for each row of halo - for windowed filters each band
+// repeats work for halo rows, so bands can't be too thin
+const int MIN_BAND_ROWS_PER_HALO_ROW = 4;
+
+/**
+ * @brief The RowBand struct - range [begin, end) of image rows.
+ */
+struct RowBand{
+    int begin;
+    int end;
+};
+
+/**
+ * @class ThreadPool
+ * @brief The ThreadPool class - fixed number of worker threads that execute queued tasks.
+ */
+class ThreadPool{
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stop;
+
+    static bool& insideWorker(){
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    void work(){
+        insideWorker() = true;
+        while (true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this](){ return stop || !tasks.empty(); });
+                if (stop && tasks.empty()){
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    /**
+     * @brief ThreadPool Start pool.
+     * @param threads Number of threads that execute tasks, calling thread is
+     * one of them, so threads - 1 workers are created.
+     */
+    explicit ThreadPool(unsigned int threads) : stop(false) {
+        for (unsigned int i = 1; i < threads; ++i){
+            workers.emplace_back(&ThreadPool::work, this);
+        }
+    }
+
+    ~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto& w : workers){
+            w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief size Number of threads that execute tasks.
+     */
+    unsigned int size() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    /**
+     * @brief run Execute given tasks and wait for all of them. Calling thread execute
+     * first task. If any task throws, first exception is rethrown after all tasks end.
+     * Called from inside of pool task, runs all tasks in calling thread.
+     * @param group Tasks to execute.
+     */
+    void run(const std::vector<std::function<void()>>& group){
+        if (group.empty()){
+            return;
+        }
+        if (workers.empty() || insideWorker() || group.size() == 1){
+            for (auto& task : group){
+                task();
+            }
+            return;
+        }
+
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        size_t remaining = group.size() - 1;
+        std::exception_ptr error;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 1; i < group.size(); ++i){
+                const std::function<void()>* task = &group[i];
+                tasks.emplace([task, &doneMutex, &doneCondition, &remaining, &error](){
+                    std::exception_ptr taskError;
+                    try {
+                        (*task)();
+                    } catch (...) {
+                        taskError = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> doneLock(doneMutex);
+                    if (taskError && !error){
+                        error = taskError;
+                    }
+                    if (--remaining == 0){
+                        doneCondition.notify_one();
+                    }
+                });
+            }
+        }
+        condition.notify_all();
+
+        std::exception_ptr firstError;
+        try {
+            insideWorker() = true;
+            group[0]();
+        } catch (...) {
+            firstError = std::current_exception();
+        }
+        insideWorker() = false;
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [&remaining](){ return remaining == 0; });
+
+        if (firstError){
+            std::rethrow_exception(firstError);
+        } else if (error){
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * @brief threadPoolHolder Global pool used by parallelForRows, by default it has one thread.
+ */
+inline std::unique_ptr<ThreadPool>& threadPoolHolder(){
+    static std::unique_ptr<ThreadPool> pool(new ThreadPool(1));
+    return pool;
+}
+
+/**
+ * @brief setThreadsNumber Set number of threads used by per pixel stages.
+ * @param threads Number of threads, 0 means number of hardware threads.
+ */
+inline void setThreadsNumber(unsigned int threads){
+    if (threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadPoolHolder().reset(new ThreadPool(threads));
+}
+
+/**
+ * @brief getThreadsNumber Get number of threads used by per pixel stages.
+ */
+inline unsigned int getThreadsNumber(){
+    return threadPoolHolder()->size();
+}
+
+/**
+ * @class ThreadsNumberGuard
+ * @brief The ThreadsNumberGuard class - set number of threads used by per pixel stages
+ * until end of scope, previous number is restored also when scope is left by exception.
+ */
+class ThreadsNumberGuard{
+private:
+    unsigned int previous;
+
+public:
+    explicit ThreadsNumberGuard(unsigned int threads) : previous(getThreadsNumber()) {
+        setThreadsNumber(threads);
+    }
+
+    ~ThreadsNumberGuard(){
+        setThreadsNumber(previous);
+    }
+
+    ThreadsNumberGuard(const ThreadsNumberGuard&) = delete;
+    ThreadsNumberGuard& operator=(const ThreadsNumberGuard&) = delete;
+};
+
+/**
+ * @brief splitRowBands Split rows into bands of similar size.
+ * @param begin First row.
+ * @param end Row after last one.
+ * @param bands Maximal number of bands.
+ * @param halo Number of rows over and under band used by windowed filter.
+ * @return Vector of bands, bands are ordered and cover whole range.
+ */
+inline std::vector<RowBand> splitRowBands(int begin, int end, unsigned int bands, int halo = 0){
+    std::vector<RowBand> result;
+    int rows = end - begin;
+    if (rows <= 0){
+        return result;
+    }
+
+    int minRows = std::max(1, halo * MIN_BAND_ROWS_PER_HALO_ROW);
+    int count = std::max(1, std::min(static_cast<int>(bands), rows / minRows));
+
+    for (int b = 0; b < count; ++b){
+        RowBand band;
+        band.begin = begin + static_cast<int>(static_cast<long long>(rows) * b / count);
+        band.end = begin + static_cast<int>(static_cast<long long>(rows) * (b + 1) / count);
+        result.emplace_back(band);
+    }
+
+    return result;
+}
+
+/**
+ * @brief parallelForRows Run body for bands of rows on global thread pool and wait.
+ * @param begin First row.
+ * @param end Row after last one.
+ * @param body Function called with range of rows [begin, end).
+ * @param halo Number of rows over and under band used by windowed filter.
+ */
+inline void parallelForRows(int begin, int end, const std::function<void(int, int)>& body, int halo = 0){
+    ThreadPool& pool = *threadPoolHolder();
+    std::vector<RowBand> bands = splitRowBands(begin, end, pool.size(), halo);
+
+    std::vector<std::function<void()>> group;
+    for (auto& band : bands){
+        group.emplace_back([&body, band](){ body(band.begin, band.end); });
+    }
+    pool.run(group);
+}
+
+#endif // PARALLEL_HPP
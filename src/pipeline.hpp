@@ -0,0 +1,164 @@
+/**
+  * Fused row streaming pipeline - rank filter, color classification by lookup table and
+  * neighbours window counting are done row by row. Only few rows of brightness and mask
+  * are kept in ring buffers, filtered image and HSV image are never saved, only final
+  * pixels map reaches memory.
+  */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+
+// std
+#include <vector>
+#include <cstdint>
+
+// lego
+#include "utils.hpp"
+
+/**
+ * @brief The RowRing class - ring buffer of fixed number of rows, row i is kept
+ * in slot i % size.
+ */
+template <typename T>
+class RowRing{
+private:
+    int rowsNumber;
+    size_t rowLength;
+    std::vector<T> data;
+
+public:
+    RowRing(int rows, size_t rowLength) : rowsNumber(rows), rowLength(rowLength), data(rows * rowLength) {}
+
+    T* row(int i){
+        return data.data() + static_cast<size_t>(i % rowsNumber) * rowLength;
+    }
+};
+
+/**
+ * @brief streamRankFilterPixelPicker Fused version of rankFilter and neighbourAwarePixelPicker with
+ * lookup table for square rank filter of given size. Each band of output rows streams rows of
+ * mask from band begin - height / 2 to band end + height / 2, number of chosen pixels in window
+ * is counted from column sums of last height rows.
+ * @param img Source BGR image.
+ * @param rank ID of pixel in rank filter window sorted by brightness.
+ * @param lut Lookup table of chosen colors.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel in neighbours window.
+ * @param level Instruction set used by rank filter.
+ * @return Pixels map, the same as from neighbourAwarePixelPicker(rankFilter(img, Size, Size, rank), ...).
+ */
+template <int Size>
+PackedPixelsMap streamRankFilterPixelPicker(const cv::Mat& img, unsigned int rank, const ColorLUT& lut,
+                                            int width, int height, float percent, SimdLevel level = detectSimdLevel()){
+    checkRankFilterArguments(Size, Size, rank);
+    checkNeighbourWindow(width, height);
+    checkBGRImage(img);
+    LEGO_PROFILE_STAGE("rank_filter_pixel_picker", img.total());
+
+    const int half = Size / 2;
+    const int halfW = width / 2, halfH = height / 2;
+    const int cols = img.cols;
+    const uint64_t* words = lut.data();
+
+    PackedPixelsMap pixelsMap(img.rows, img.cols);
+    // pixels map and ring buffers, filtered row and column sums of each band
+    LEGO_PROFILE_MEMORY(pixelsMap.stride() * pixelsMap.rows() * sizeof(uint64_t)
+                        + splitRowBands(halfH, img.rows - halfH, getThreadsNumber(), halfH + half).size()
+                        * cols * (Size * sizeof(uint16_t) + height + sizeof(cv::Vec3b) + sizeof(uint32_t)));
+
+    parallelForRows(halfH, img.rows - halfH, [&](int begin, int end){
+        RowRing<uint16_t> brightness(Size, cols);
+        RowRing<uint8_t> mask(height, cols);
+        std::vector<cv::Vec3b> filtered(cols);
+        std::vector<uint32_t> columnSums(cols, 0);
+
+        int nextBrightness = std::max(0, begin - halfH - half);
+
+        for (int r = begin - halfH; r < end + halfH; ++r){
+            // filtered row, rows at image border are copied
+            const cv::Vec3b* src = img.ptr<cv::Vec3b>(r);
+            if (r < half || r >= img.rows - half){
+                std::copy(src, src + cols, filtered.begin());
+            } else {
+                for (; nextBrightness <= r + half; ++nextBrightness){
+                    brightnessRow(img.ptr<uint8_t>(nextBrightness), cols, brightness.row(nextBrightness));
+                }
+                const uint16_t* rows[Size];
+                for (int k = 0; k < Size; ++k){
+                    rows[k] = brightness.row(r - half + k);
+                }
+                rankFilterRow<Size>(img, rows, filtered.data(), r, rank, level);
+            }
+
+            // mask row replaces row that leaves window
+            uint8_t* current = mask.row(r);
+            if (r - height >= begin - halfH){
+                for (int j = 0; j < cols; ++j){
+                    columnSums[j] -= current[j];
+                }
+            }
+            for (int j = 0; j < cols; ++j){
+                uint32_t index = ColorLUT::index(filtered[j][0], filtered[j][1], filtered[j][2]);
+                current[j] = (words[index / ColorLUT::WORD_BITS] >> (index % ColorLUT::WORD_BITS)) & 1u;
+                columnSums[j] += current[j];
+            }
+
+            // window of output row i is rows [i - halfH, i + halfH], so it is complete now
+            const int i = r - halfH;
+            if (i < begin){
+                continue;
+            }
+
+            uint64_t* dst = pixelsMap.row(i);
+            uint32_t num = 0;
+            for (int j = 0; j < std::min(width - 1, cols); ++j){
+                num += columnSums[j];
+            }
+            for (int j = halfW; j < cols - halfW; ++j){
+                num += columnSums[j + halfW];
+                if (static_cast<float>(num)/static_cast<float>(width * height)>percent){
+                    dst[j / PackedPixelsMap::WORD_BITS] |= uint64_t(1) << (j % PackedPixelsMap::WORD_BITS);
+                }
+                num -= columnSums[j - halfW];
+            }
+        }
+    }, halfH + half);
+
+    return pixelsMap;
+}
+
+/**
+ * @brief streamRankFilterPixelPicker Fused version of rankFilter and neighbourAwarePixelPicker with
+ * lookup table. Only square rank filters that use sorting networks (3, 5, 7) are fused, others
+ * run both stages one after another.
+ * @param img Source BGR image.
+ * @param rankWidth Width of rank filter window.
+ * @param rankHeight Height of rank filter window.
+ * @param rank ID of pixel in rank filter window sorted by brightness.
+ * @param lut Lookup table of chosen colors.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel in neighbours window.
+ * @return Pixels map.
+ */
+inline PackedPixelsMap streamRankFilterPixelPicker(const cv::Mat& img, int rankWidth, int rankHeight, unsigned int rank,
+                                                   const ColorLUT& lut, int width, int height, float percent){
+    if (rankWidth == rankHeight){
+        switch (rankWidth){
+        case 3:
+            return streamRankFilterPixelPicker<3>(img, rank, lut, width, height, percent);
+        case 5:
+            return streamRankFilterPixelPicker<5>(img, rank, lut, width, height, percent);
+        case 7:
+            return streamRankFilterPixelPicker<7>(img, rank, lut, width, height, percent);
+        }
+    }
+
+    return neighbourAwarePixelPicker(rankFilter(img, rankWidth, rankHeight, rank), lut, width, height, percent);
+}
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,243 @@
+/**
+  * Per stage timers and counters. Stages are measured only when LEGO_PROFILING is defined
+  * (cmake option LEGO_PROFILING), otherwise LEGO_PROFILE_* macros are empty and their
+  * arguments are not evaluated. Results go to ProfileReport set for current thread by
+  * ProfileSession, so each batch worker has its own report. Stages run by thread without
+  * session (for example inside row bands) are not measured.
+  */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// std
+#include <map>
+#include <string>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+// lego
+#include "json.hpp"
+
+/**
+ * @brief The StageStats struct - measurements of one stage.
+ * calls - number of stage calls.
+ * seconds - wall time of all calls.
+ * pixels - number of pixels processed by all calls.
+ */
+struct StageStats{
+    size_t calls = 0;
+    double seconds = 0.0;
+    size_t pixels = 0;
+
+    void merge(const StageStats& other){
+        calls += other.calls;
+        seconds += other.seconds;
+        pixels += other.pixels;
+    }
+
+    /**
+     * @brief megapixelsPerSecond Throughput of stage, 0 if stage doesn't process pixels.
+     */
+    double megapixelsPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(pixels) / seconds / 1e6 : 0.0;
+    }
+};
+
+/**
+ * @class ProfileReport
+ * @brief The ProfileReport class - stages, counters and size of intermediate buffers
+ * of one image or of whole batch.
+ */
+class ProfileReport{
+public:
+    std::map<std::string, StageStats> stages;
+    std::map<std::string, size_t> counters;
+    size_t currentBytes = 0;
+    size_t peakBytes = 0;
+    size_t images = 0;
+
+    void addStage(const std::string& name, double seconds, size_t pixels){
+        StageStats& stage = stages[name];
+        stage.calls += 1;
+        stage.seconds += seconds;
+        stage.pixels += pixels;
+    }
+
+    void addCounter(const std::string& name, size_t value){
+        counters[name] += value;
+    }
+
+    void allocate(size_t bytes){
+        currentBytes += bytes;
+        peakBytes = std::max(peakBytes, currentBytes);
+    }
+
+    void release(size_t bytes){
+        currentBytes -= std::min(bytes, currentBytes);
+    }
+
+    /**
+     * @brief merge Add report of other image, peak of intermediate buffers is maximum of peaks.
+     * @param other Report to add.
+     */
+    void merge(const ProfileReport& other){
+        for (auto& stage : other.stages){
+            stages[stage.first].merge(stage.second);
+        }
+        for (auto& counter : other.counters){
+            counters[counter.first] += counter.second;
+        }
+        peakBytes = std::max(peakBytes, other.peakBytes);
+        images += other.images;
+    }
+
+    /**
+     * @brief writeJSON Write report as one line JSON object.
+     * @param out Output stream.
+     * @param name Name of report, for example image path, written as "name" field.
+     */
+    void writeJSON(std::ostream& out, const std::string& name) const {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision(std::numeric_limits<double>::max_digits10);
+
+        out << "{\"name\":" << jsonString(name) << ",\"images\":" << images << ",\"peak_bytes\":" << peakBytes << ",\"stages\":{";
+        bool first = true;
+        for (auto& stage : stages){
+            out << (first ? "" : ",") << "\"" << stage.first << "\":{\"calls\":" << stage.second.calls
+                << ",\"seconds\":" << stage.second.seconds << ",\"pixels\":" << stage.second.pixels
+                << ",\"megapixels_per_second\":" << stage.second.megapixelsPerSecond() << "}";
+            first = false;
+        }
+        out << "},\"counters\":{";
+        first = true;
+        for (auto& counter : counters){
+            out << (first ? "" : ",") << "\"" << counter.first << "\":" << counter.second;
+            first = false;
+        }
+        out << "}}\n";
+
+        out.precision(precision);
+        out.flags(flags);
+    }
+};
+
+/**
+ * @brief currentProfileReport Report of current thread, nullptr if stages are not measured.
+ */
+inline ProfileReport*& currentProfileReport(){
+    thread_local ProfileReport* report = nullptr;
+    return report;
+}
+
+/**
+ * @class ProfileSession
+ * @brief The ProfileSession class - sets report of current thread for its lifetime and
+ * counts one image in it.
+ */
+class ProfileSession{
+private:
+    ProfileReport* previous;
+
+public:
+    explicit ProfileSession(ProfileReport& report) : previous(currentProfileReport()) {
+        currentProfileReport() = &report;
+        report.images += 1;
+    }
+
+    ~ProfileSession(){
+        currentProfileReport() = previous;
+    }
+
+    ProfileSession(const ProfileSession&) = delete;
+    ProfileSession& operator=(const ProfileSession&) = delete;
+};
+
+/**
+ * @class ScopedStageTimer
+ * @brief The ScopedStageTimer class - measures wall time from construction to destruction
+ * and adds it to stage of current report.
+ */
+class ScopedStageTimer{
+private:
+    ProfileReport* report;
+    const char* name;
+    size_t pixels;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedStageTimer(const char* name, size_t pixels)
+        : report(currentProfileReport()), name(name), pixels(pixels), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStageTimer(){
+        if (report){
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            report->addStage(name, elapsed.count(), pixels);
+        }
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
+
+/**
+ * @class ScopedAllocation
+ * @brief The ScopedAllocation class - intermediate buffer of given size that lives until
+ * end of scope, counted in current and peak bytes of current report.
+ */
+class ScopedAllocation{
+private:
+    ProfileReport* report;
+    size_t bytes;
+
+public:
+    explicit ScopedAllocation(size_t bytes) : report(currentProfileReport()), bytes(bytes) {
+        if (report){
+            report->allocate(bytes);
+        }
+    }
+
+    ~ScopedAllocation(){
+        if (report){
+            report->release(bytes);
+        }
+    }
+
+    ScopedAllocation(const ScopedAllocation&) = delete;
+    ScopedAllocation& operator=(const ScopedAllocation&) = delete;
+};
+
+/**
+ * @brief profileCount Add value to counter of current report.
+ */
+inline void profileCount(const char* name, size_t value){
+    if (ProfileReport* report = currentProfileReport()){
+        report->addCounter(name, value);
+    }
+}
+
+#define LEGO_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LEGO_PROFILE_CONCAT(a, b) LEGO_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef LEGO_PROFILING
+// if stages are measured, reports are empty otherwise
+const bool PROFILING_ENABLED = true;
+// measure rest of scope as stage with given name and number of pixels
+#define LEGO_PROFILE_STAGE(name, pixels) \
+    ScopedStageTimer LEGO_PROFILE_CONCAT(legoStageTimer, __LINE__)((name), static_cast<size_t>(pixels))
+// count buffer of given size as allocated until end of scope
+#define LEGO_PROFILE_MEMORY(bytes) \
+    ScopedAllocation LEGO_PROFILE_CONCAT(legoAllocation, __LINE__)(static_cast<size_t>(bytes))
+// add value to counter
+#define LEGO_PROFILE_COUNT(name, value) profileCount((name), static_cast<size_t>(value))
+#else
+const bool PROFILING_ENABLED = false;
+#define LEGO_PROFILE_STAGE(name, pixels) ((void)0)
+#define LEGO_PROFILE_MEMORY(bytes) ((void)0)
+#define LEGO_PROFILE_COUNT(name, value) ((void)0)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,514 @@
+/**
+  * Rank filter engines. Brightness of pixel is a sum of its BGR channels, that
+  * keeps exactly the same order as (b+g+r)/3.0 used by reference filter, but
+  * it's an integer in range [0, 765] and can be used as histogram bin.
+  * Pixels with the same brightness are ordered by column and then by row, so
+  * every engine choose the same pixel from neighbours window.
+  */
+
+#ifndef RANK_FILTER_HPP
+#define RANK_FILTER_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+
+// std
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// lego
+#include "parallel.hpp"
+
+// number of possible brightness values (b+g+r), rounded up to multiple of RANK_FILTER_FINE_BINS
+const int RANK_FILTER_BINS = 768;
+// histogram is two level - coarse bins group RANK_FILTER_FINE_BINS fine bins
+const int RANK_FILTER_FINE_BINS = 16;
+const int RANK_FILTER_COARSE_BINS = RANK_FILTER_BINS / RANK_FILTER_FINE_BINS;
+
+/**
+ * @brief checkRankFilterArguments Check if rank filter arguments are correct,
+ * throws std::runtime_error otherwise.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ */
+inline void checkRankFilterArguments(int width, int height, unsigned int rank){
+    if(width<0 || height<0){
+        throw std::runtime_error("");
+    }
+    else if(rank>=static_cast<unsigned int>(width*height)){
+        throw std::runtime_error("Wrong rank value!");
+    }
+    else if(height%2 == 0 || width%2 == 0){
+        throw std::runtime_error("Filter size not odd!");
+    }
+}
+
+/**
+ * @brief brightnessRow Count brightness of each pixel of row.
+ * @param src Row of BGR pixels.
+ * @param cols Number of pixels.
+ * @param dst Buffer for b+g+r values.
+ */
+inline void brightnessRow(const uint8_t* src, int cols, uint16_t* dst){
+    for (int j = 0; j < cols; ++j) {
+        dst[j] = static_cast<uint16_t>(src[3*j] + src[3*j + 1] + src[3*j + 2]);
+    }
+}
+
+/**
+ * @brief brightnessPlane Count brightness of each image pixel.
+ * @param img BGR image.
+ * @return One channel CV_16UC1 image with b+g+r values.
+ */
+inline cv::Mat brightnessPlane(const cv::Mat& img){
+    cv::Mat res(img.rows, img.cols, CV_16UC1);
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end; ++i){
+            brightnessRow(img.ptr<uint8_t>(i), img.cols, res.ptr<uint16_t>(i));
+        }
+    });
+
+    return res;
+}
+
+/**
+ * @brief copyRankFilterBorder Copy pixels that are not changed by rank filter - those
+ * closer to image edge than half of window size.
+ * @param img Source image.
+ * @param res Result image.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ */
+inline void copyRankFilterBorder(const cv::Mat& img, cv::Mat& res, int width, int height){
+    for (int i = 0; i < img.rows ; ++i){
+        const cv::Vec3b* src = img.ptr<cv::Vec3b>(i);
+        cv::Vec3b* dst = res.ptr<cv::Vec3b>(i);
+        if (i < (height / 2) || i>= (img.rows - height / 2)){
+            std::copy(src, src + img.cols, dst);
+        } else {
+            for (int j = 0; j < std::min(width / 2, img.cols); ++j){
+                dst[j] = src[j];
+            }
+            for (int j = std::max(img.cols - width / 2, 0); j < img.cols; ++j){
+                dst[j] = src[j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief rankFilterSort Reference rank filter - sort whole neighbours window for each pixel.
+ * @param img Image to convertion.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param rank ID of pixel in neighbours window sorted by brightness - pixel with given ID
+ * is choose as a new value in result image.
+ * @return Converted image.
+ */
+inline cv::Mat rankFilterSort(const cv::Mat& img, int width, int height, unsigned int rank){
+    checkRankFilterArguments(width, height, rank);
+
+    // create copy
+    cv::Mat res(img.rows, img.cols, CV_8UC3);
+
+    // get iterators
+    cv::Mat_<cv::Vec3b> new_iter = res;
+    cv::Mat_<cv::Vec3b> original_iter = img;
+
+    for (int i = 0; i < img.rows ; ++i){
+        for (int j = 0; j < img.cols; ++j) {
+
+            // copy not change pixels
+            if (i < (height / 2) || i>= (img.rows - height / 2) || j < (width / 2) || j>=(img.cols - width / 2)){
+                new_iter(i, j)[0] = original_iter(i, j)[0];
+                new_iter(i, j)[1] = original_iter(i, j)[1];
+                new_iter(i, j)[2] = original_iter(i, j)[2];
+            }
+            // execute filter for other pixels
+            else {
+                std::vector<std::pair<float, std::pair<int, int>>> vec;
+                for (int row = i - height/2; row<=i + height/2; ++row)
+                {
+                    for (int col = j - width / 2; col <= j + width / 2; ++col) {
+                        double c = (original_iter(row, col)[0] + original_iter(row, col)[1] + original_iter(row, col)[2]) / 3.0;
+                        vec.emplace_back(std::pair<double, std::pair<int, int>>(c, std::pair<int, int>(row, col)));
+                    }
+                }
+
+                // equal brightness - order by column, then by row
+                std::sort(vec.begin(), vec.end(),
+                    [](const std::pair<float, std::pair<int, int>>&a, const std::pair<float, std::pair<int, int>>&b) -> bool{
+                    if (a.first != b.first){
+                        return a.first < b.first;
+                    } else if (a.second.second != b.second.second){
+                        return a.second.second < b.second.second;
+                    }
+                    return a.second.first < b.second.first;});
+
+                new_iter(i, j)[0] = original_iter(vec[rank].second.first, vec[rank].second.second)[0];
+                new_iter(i, j)[1] = original_iter(vec[rank].second.first, vec[rank].second.second)[1];
+                new_iter(i, j)[2] = original_iter(vec[rank].second.first, vec[rank].second.second)[2];
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @class RankHistogram
+ * @brief The RankHistogram class - two level brightness histogram of neighbours window.
+ * Coarse level let find bin of given rank in RANK_FILTER_COARSE_BINS + RANK_FILTER_FINE_BINS
+ * steps instead of RANK_FILTER_BINS.
+ */
+class RankHistogram{
+private:
+    uint32_t fine[RANK_FILTER_BINS];
+    uint32_t coarse[RANK_FILTER_COARSE_BINS];
+    uint32_t total;
+
+public:
+    RankHistogram(){
+        clear();
+    }
+
+    void clear(){
+        std::fill(fine, fine + RANK_FILTER_BINS, 0);
+        std::fill(coarse, coarse + RANK_FILTER_COARSE_BINS, 0);
+        total = 0;
+    }
+
+    void add(uint16_t bin){
+        ++fine[bin];
+        ++coarse[bin / RANK_FILTER_FINE_BINS];
+        ++total;
+    }
+
+    void remove(uint16_t bin){
+        --fine[bin];
+        --coarse[bin / RANK_FILTER_FINE_BINS];
+        --total;
+    }
+
+    /**
+     * @brief find Find bin that contains element with given rank.
+     * @param rank Rank of element, must be lower than number of elements.
+     * @param inBin Set to rank of element between elements in found bin.
+     * @return Bin ID.
+     */
+    uint16_t find(uint32_t rank, uint32_t& inBin) const {
+        // search from side closer to rank
+        if (rank < total / 2){
+            uint32_t below = 0;
+            int c = 0;
+            while (below + coarse[c] <= rank){
+                below += coarse[c++];
+            }
+            int b = c * RANK_FILTER_FINE_BINS;
+            while (below + fine[b] <= rank){
+                below += fine[b++];
+            }
+            inBin = rank - below;
+            return static_cast<uint16_t>(b);
+        } else {
+            uint32_t fromTop = total - 1 - rank;
+            uint32_t above = 0;
+            int c = RANK_FILTER_COARSE_BINS - 1;
+            while (above + coarse[c] <= fromTop){
+                above += coarse[c--];
+            }
+            int b = c * RANK_FILTER_FINE_BINS + RANK_FILTER_FINE_BINS - 1;
+            while (above + fine[b] <= fromTop){
+                above += fine[b--];
+            }
+            inBin = rank - (total - above - fine[b]);
+            return static_cast<uint16_t>(b);
+        }
+    }
+};
+
+/**
+ * @brief rankFilterHistogram Rank filter that keeps brightness histogram of neighbours
+ * window and slide it across each row (Huang). Additional per column histograms
+ * (Perreault-Hebert) are used to find which of pixels with the same brightness is chosen
+ * without scanning whole window. Cost per pixel grows with height of window,
+ * not with window area. Result is the same as from rankFilterSort.
+ * @param img Image to convertion.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ * @return Converted image.
+ */
+inline cv::Mat rankFilterHistogram(const cv::Mat& img, int width, int height, unsigned int rank){
+    checkRankFilterArguments(width, height, rank);
+
+    cv::Mat res(img.rows, img.cols, CV_8UC3);
+    copyRankFilterBorder(img, res, width, height);
+
+    if (img.rows < height || img.cols < width){
+        return res;
+    }
+
+    const int halfW = width / 2;
+    const int halfH = height / 2;
+    cv::Mat brightness = brightnessPlane(img);
+
+    // each band of rows has its own column histograms
+    parallelForRows(halfH, img.rows - halfH, [&](int begin, int end){
+        // histogram of each image column limited to rows of current window
+        std::vector<uint16_t> columns(static_cast<size_t>(img.cols) * RANK_FILTER_BINS, 0);
+        for (int row = begin - halfH; row < begin + halfH; ++row){
+            const uint16_t* b = brightness.ptr<uint16_t>(row);
+            for (int col = 0; col < img.cols; ++col){
+                ++columns[static_cast<size_t>(col) * RANK_FILTER_BINS + b[col]];
+            }
+        }
+
+        RankHistogram kernel;
+
+        for (int i = begin; i < end; ++i){
+            // move column histograms one row down
+            const uint16_t* added = brightness.ptr<uint16_t>(i + halfH);
+            for (int col = 0; col < img.cols; ++col){
+                ++columns[static_cast<size_t>(col) * RANK_FILTER_BINS + added[col]];
+            }
+            if (i > begin){
+                const uint16_t* removed = brightness.ptr<uint16_t>(i - halfH - 1);
+                for (int col = 0; col < img.cols; ++col){
+                    --columns[static_cast<size_t>(col) * RANK_FILTER_BINS + removed[col]];
+                }
+            }
+
+            // fill window for first pixel in row
+            kernel.clear();
+            for (int row = i - halfH; row <= i + halfH; ++row){
+                const uint16_t* b = brightness.ptr<uint16_t>(row);
+                for (int col = 0; col < width; ++col){
+                    kernel.add(b[col]);
+                }
+            }
+
+            cv::Vec3b* dst = res.ptr<cv::Vec3b>(i);
+
+            for (int j = halfW; j < img.cols - halfW; ++j){
+                // slide window - replace left column with right one
+                if (j > halfW){
+                    for (int row = i - halfH; row <= i + halfH; ++row){
+                        const uint16_t* b = brightness.ptr<uint16_t>(row);
+                        kernel.remove(b[j - halfW - 1]);
+                        kernel.add(b[j + halfW]);
+                    }
+                }
+
+                uint32_t inBin;
+                uint16_t bin = kernel.find(rank, inBin);
+
+                // find column and row of chosen pixel
+                int col = j - halfW;
+                while (columns[static_cast<size_t>(col) * RANK_FILTER_BINS + bin] <= inBin){
+                    inBin -= columns[static_cast<size_t>(col) * RANK_FILTER_BINS + bin];
+                    ++col;
+                }
+                int row = i - halfH;
+                for (;; ++row){
+                    if (brightness.ptr<uint16_t>(row)[col] == bin){
+                        if (inBin == 0){
+                            break;
+                        }
+                        --inBin;
+                    }
+                }
+
+                dst[j] = img.ptr<cv::Vec3b>(row)[col];
+            }
+        }
+    }, halfH);
+
+    return res;
+}
+
+/**
+ * @brief sortingNetworkLength Count comparators of Batcher odd-even merge sort network
+ * for n elements, comparators that touch only padding elements are skipped.
+ * @param n Number of elements.
+ * @return Number of comparators.
+ */
+constexpr int sortingNetworkLength(int n){
+    int padded = 1;
+    while (padded < n){
+        padded <<= 1;
+    }
+
+    int length = 0;
+    for (int p = 1; p < padded; p <<= 1){
+        for (int k = p; k >= 1; k >>= 1){
+            for (int j = k % p; j + k < padded; j += 2 * k){
+                for (int i = 0; i < k && i + j + k < padded; ++i){
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n){
+                        ++length;
+                    }
+                }
+            }
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief The SortingNetwork struct - Batcher odd-even merge sort network for N elements
+ * generated at compile time. Padding elements (up to power of 2) would be bigger than
+ * all others, so comparators with padding are no-op and are skipped.
+ */
+template <int N>
+struct SortingNetwork{
+    static constexpr int LENGTH = sortingNetworkLength(N);
+    int first[LENGTH];
+    int second[LENGTH];
+
+    constexpr SortingNetwork() : first{}, second{} {
+        int padded = 1;
+        while (padded < N){
+            padded <<= 1;
+        }
+
+        int id = 0;
+        for (int p = 1; p < padded; p <<= 1){
+            for (int k = p; k >= 1; k >>= 1){
+                for (int j = k % p; j + k < padded; j += 2 * k){
+                    for (int i = 0; i < k && i + j + k < padded; ++i){
+                        if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < N){
+                            first[id] = i + j;
+                            second[id] = i + j + k;
+                            ++id;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+template <int N>
+constexpr SortingNetwork<N> SORTING_NETWORK{};
+
+/**
+ * @brief compareSwap Branch free comparator - put lower value to a and higher to b.
+ */
+inline void compareSwap(uint16_t& a, uint16_t& b){
+    uint16_t low = std::min(a, b);
+    b = std::max(a, b);
+    a = low;
+}
+
+/**
+ * @brief sortWithNetwork Sort N values with unrolled sorting network.
+ * @param values Array of N values.
+ */
+template <int N, std::size_t... I>
+inline void sortWithNetwork(uint16_t* values, std::index_sequence<I...>){
+    int unroll[] = {0, (compareSwap(values[SORTING_NETWORK<N>.first[I]], values[SORTING_NETWORK<N>.second[I]]), 0)...};
+    (void)unroll;
+}
+
+template <int N>
+inline void sortWithNetwork(uint16_t* values){
+    sortWithNetwork<N>(values, std::make_index_sequence<SortingNetwork<N>::LENGTH>());
+}
+
+// network key is 16 bit: brightness (up to 765 - 10 bits) in higher bits and
+// position in window in lower bits
+const int RANK_NETWORK_POSITION_BITS = 6;
+const uint16_t RANK_NETWORK_POSITION_MASK = (1u << RANK_NETWORK_POSITION_BITS) - 1;
+
+/**
+ * @brief rankNetworkRow Run sorting network rank filter for part of one image row.
+ * @param img Source image.
+ * @param rows Brightness of Size rows around filtered row, from row i - Size / 2.
+ * @param dst Result row.
+ * @param i Row index.
+ * @param begin First column to filter.
+ * @param end Column after last one to filter.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ */
+template <int Size>
+void rankNetworkRow(const cv::Mat& img, const uint16_t* const* rows, cv::Vec3b* dst, int i, int begin, int end, unsigned int rank){
+    const int half = Size / 2;
+
+    for (int j = begin; j < end; ++j){
+        uint16_t keys[Size * Size];
+        for (int col = 0; col < Size; ++col){
+            for (int row = 0; row < Size; ++row){
+                keys[col * Size + row] = static_cast<uint16_t>((rows[row][j - half + col] << RANK_NETWORK_POSITION_BITS) | (col * Size + row));
+            }
+        }
+
+        sortWithNetwork<Size * Size>(keys);
+
+        int position = keys[rank] & RANK_NETWORK_POSITION_MASK;
+        dst[j] = img.ptr<cv::Vec3b>(i - half + position % Size)[j - half + position / Size];
+    }
+}
+
+/**
+ * @brief brightnessRows Take pointers to brightness of Size rows around row i.
+ */
+template <int Size>
+void brightnessRows(const cv::Mat& brightness, int i, const uint16_t** rows){
+    for (int row = 0; row < Size; ++row){
+        rows[row] = brightness.ptr<uint16_t>(i - Size / 2 + row);
+    }
+}
+
+/**
+ * @brief rankNetworkRow Run sorting network rank filter for part of one image row.
+ * @param img Source image.
+ * @param brightness Brightness plane of source image.
+ * @param res Result image.
+ * @param i Row index.
+ * @param begin First column to filter.
+ * @param end Column after last one to filter.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ */
+template <int Size>
+void rankNetworkRow(const cv::Mat& img, const cv::Mat& brightness, cv::Mat& res, int i, int begin, int end, unsigned int rank){
+    const uint16_t* rows[Size];
+    brightnessRows<Size>(brightness, i, rows);
+    rankNetworkRow<Size>(img, rows, res.ptr<cv::Vec3b>(i), i, begin, end, rank);
+}
+
+/**
+ * @brief rankFilterNetwork Rank filter for small square windows. Brightness is counted once
+ * for each pixel, then keys (brightness, position in window) are sorted by sorting
+ * network without any allocation or branch. Position in window is column major, so
+ * result is the same as from rankFilterSort.
+ * @param img Image to convertion.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ * @return Converted image.
+ */
+template <int Size>
+cv::Mat rankFilterNetwork(const cv::Mat& img, unsigned int rank){
+    static_assert(Size % 2 == 1, "Filter size not odd!");
+    static_assert(Size * Size <= RANK_NETWORK_POSITION_MASK + 1, "Filter too big for network!");
+    checkRankFilterArguments(Size, Size, rank);
+
+    cv::Mat res(img.rows, img.cols, CV_8UC3);
+    copyRankFilterBorder(img, res, Size, Size);
+
+    const int half = Size / 2;
+    cv::Mat brightness = brightnessPlane(img);
+
+    parallelForRows(half, img.rows - half, [&](int begin, int end){
+        for (int i = begin; i < end; ++i){
+            rankNetworkRow<Size>(img, brightness, res, i, half, img.cols - half, rank);
+        }
+    });
+
+    return res;
+}
+
+#endif // RANK_FILTER_HPP
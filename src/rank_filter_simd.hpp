@@ -0,0 +1,187 @@
+/**
+  * Vectorized sorting network rank filter. Network keys of neighbouring output pixels
+  * are kept in lanes of one SIMD register, so the same vertical min/max network as in
+  * rankFilterNetwork sorts 16 (AVX2) or 8 (SSE4.1) pixels at once. Instruction set
+  * is chosen at runtime, so binary don't need to be built with -mavx2.
+  */
+
+#ifndef RANK_FILTER_SIMD_HPP
+#define RANK_FILTER_SIMD_HPP
+
+// opencv
+#include <opencv2/core/core.hpp>
+
+// std
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+// lego
+#include "rank_filter.hpp"
+#include "simd.hpp"
+
+#ifdef LEGO_SIMD
+
+__attribute__((target("avx2")))
+inline void compareSwapAVX2(__m256i& a, __m256i& b){
+    __m256i low = _mm256_min_epu16(a, b);
+    b = _mm256_max_epu16(a, b);
+    a = low;
+}
+
+template <int N, std::size_t... I>
+__attribute__((target("avx2")))
+inline void sortWithNetworkAVX2(__m256i* values, std::index_sequence<I...>){
+    int unroll[] = {0, (compareSwapAVX2(values[SORTING_NETWORK<N>.first[I]], values[SORTING_NETWORK<N>.second[I]]), 0)...};
+    (void)unroll;
+}
+
+__attribute__((target("sse4.1")))
+inline void compareSwapSSE41(__m128i& a, __m128i& b){
+    __m128i low = _mm_min_epu16(a, b);
+    b = _mm_max_epu16(a, b);
+    a = low;
+}
+
+template <int N, std::size_t... I>
+__attribute__((target("sse4.1")))
+inline void sortWithNetworkSSE41(__m128i* values, std::index_sequence<I...>){
+    int unroll[] = {0, (compareSwapSSE41(values[SORTING_NETWORK<N>.first[I]], values[SORTING_NETWORK<N>.second[I]]), 0)...};
+    (void)unroll;
+}
+
+/**
+ * @brief rankNetworkRowAVX2 Filter one image row, 16 pixels in each step.
+ * @return First column that was not filtered.
+ */
+template <int Size>
+__attribute__((target("avx2")))
+int rankNetworkRowAVX2(const cv::Mat& img, const uint16_t* const* rows, cv::Vec3b* dst, int i, unsigned int rank){
+    const int half = Size / 2;
+    const int lanes = 16;
+
+    int j = half;
+    for (; j + lanes <= img.cols - half; j += lanes){
+        __m256i keys[Size * Size];
+        for (int col = 0; col < Size; ++col){
+            for (int row = 0; row < Size; ++row){
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[row] + j - half + col));
+                keys[col * Size + row] = _mm256_or_si256(_mm256_slli_epi16(b, RANK_NETWORK_POSITION_BITS),
+                                                         _mm256_set1_epi16(static_cast<short>(col * Size + row)));
+            }
+        }
+
+        sortWithNetworkAVX2<Size * Size>(keys, std::make_index_sequence<SortingNetwork<Size * Size>::LENGTH>());
+
+        alignas(32) uint16_t chosen[lanes];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(chosen), keys[rank]);
+        for (int l = 0; l < lanes; ++l){
+            int position = chosen[l] & RANK_NETWORK_POSITION_MASK;
+            dst[j + l] = img.ptr<cv::Vec3b>(i - half + position % Size)[j + l - half + position / Size];
+        }
+    }
+
+    return j;
+}
+
+/**
+ * @brief rankNetworkRowSSE41 Filter one image row, 8 pixels in each step.
+ * @return First column that was not filtered.
+ */
+template <int Size>
+__attribute__((target("sse4.1")))
+int rankNetworkRowSSE41(const cv::Mat& img, const uint16_t* const* rows, cv::Vec3b* dst, int i, unsigned int rank){
+    const int half = Size / 2;
+    const int lanes = 8;
+
+    int j = half;
+    for (; j + lanes <= img.cols - half; j += lanes){
+        __m128i keys[Size * Size];
+        for (int col = 0; col < Size; ++col){
+            for (int row = 0; row < Size; ++row){
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[row] + j - half + col));
+                keys[col * Size + row] = _mm_or_si128(_mm_slli_epi16(b, RANK_NETWORK_POSITION_BITS),
+                                                      _mm_set1_epi16(static_cast<short>(col * Size + row)));
+            }
+        }
+
+        sortWithNetworkSSE41<Size * Size>(keys, std::make_index_sequence<SortingNetwork<Size * Size>::LENGTH>());
+
+        alignas(16) uint16_t chosen[lanes];
+        _mm_store_si128(reinterpret_cast<__m128i*>(chosen), keys[rank]);
+        for (int l = 0; l < lanes; ++l){
+            int position = chosen[l] & RANK_NETWORK_POSITION_MASK;
+            dst[j + l] = img.ptr<cv::Vec3b>(i - half + position % Size)[j + l - half + position / Size];
+        }
+    }
+
+    return j;
+}
+
+#endif // LEGO_SIMD
+
+/**
+ * @brief rankFilterRow Filter whole image row with vectorized network, pixels at the end of
+ * row that don't fill whole register are filtered by scalar network, border columns are copied.
+ * @param img Image to convertion.
+ * @param rows Brightness of Size rows around filtered row, from row i - Size / 2.
+ * @param dst Result row.
+ * @param i Row index.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ * @param level Instruction set to use.
+ */
+template <int Size>
+void rankFilterRow(const cv::Mat& img, const uint16_t* const* rows, cv::Vec3b* dst, int i, unsigned int rank, SimdLevel level){
+    const int half = Size / 2;
+    const cv::Vec3b* src = img.ptr<cv::Vec3b>(i);
+    for (int j = 0; j < std::min(half, img.cols); ++j){
+        dst[j] = src[j];
+    }
+    for (int j = std::max(half, img.cols - half); j < img.cols; ++j){
+        dst[j] = src[j];
+    }
+
+    int j = half;
+#ifdef LEGO_SIMD
+    if (level == SimdLevel::AVX2){
+        j = rankNetworkRowAVX2<Size>(img, rows, dst, i, rank);
+    } else if (level == SimdLevel::SSE41){
+        j = rankNetworkRowSSE41<Size>(img, rows, dst, i, rank);
+    }
+#else
+    (void)level;
+#endif
+    rankNetworkRow<Size>(img, rows, dst, i, j, img.cols - half, rank);
+}
+
+/**
+ * @brief rankFilterSimd Vectorized version of rankFilterNetwork.
+ * @param img Image to convertion.
+ * @param rank ID of pixel in neighbours window sorted by brightness.
+ * @param level Instruction set to use, by default best supported by processor.
+ * @return Converted image.
+ */
+template <int Size>
+cv::Mat rankFilterSimd(const cv::Mat& img, unsigned int rank, SimdLevel level = detectSimdLevel()){
+    static_assert(Size % 2 == 1, "Filter size not odd!");
+    static_assert(Size * Size <= RANK_NETWORK_POSITION_MASK + 1, "Filter too big for network!");
+    checkRankFilterArguments(Size, Size, rank);
+
+    cv::Mat res(img.rows, img.cols, CV_8UC3);
+    copyRankFilterBorder(img, res, Size, Size);
+
+    const int half = Size / 2;
+    cv::Mat brightness = brightnessPlane(img);
+
+    parallelForRows(half, img.rows - half, [&](int begin, int end){
+        for (int i = begin; i < end; ++i){
+            const uint16_t* rows[Size];
+            brightnessRows<Size>(brightness, i, rows);
+            rankFilterRow<Size>(img, rows, res.ptr<cv::Vec3b>(i), i, rank, level);
+        }
+    });
+
+    return res;
+}
+
+#endif // RANK_FILTER_SIMD_HPP
@@ -1,5 +1,6 @@
 /**
   * Module that contains function design to find image segments.
+  * Segments are 4-connected by default, connectivity (4 or 8) is template parameter.
   */
 
 #ifndef SEGMENTATION_HPP
@@ -11,9 +12,11 @@
 #include<vector>
 #include<queue>
 #include<limits>
+#include<algorithm>
 
 // lego
 #include "utils.hpp"
+#include "labelling.hpp"
 
 using PixelPos = std::pair<unsigned int, unsigned int>;
 
@@ -27,30 +30,56 @@ struct Segment{
 };
 
 /**
- * @brief findSegments Find segments in given pixels map using simple floodfill variant.
+ * @brief The RunSegment struct - segment saved as horizontal runs of pixels, ordered
+ * row by row. Memory grows with segment perimeter, not with its area.
+ */
+struct RunSegment{
+    std::vector<PixelRun> runs;
+    unsigned int id;
+
+    /**
+     * @brief size Number of segment pixels.
+     */
+    size_t size() const {
+        size_t result = 0;
+        for (auto& run : runs){
+            result += run.colEnd - run.colStart;
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief findSegmentsFloodFill Find segments in given pixels map using simple floodfill variant.
  * @param pixels Map of chosen pixels.
  * @return Vector of segments.
  */
-std::vector<Segment> findSegments(const PixelsMap& pixels){
+template <int Connectivity = 4>
+std::vector<Segment> findSegmentsFloodFill(const PackedPixelsMap& pixels){
+    static_assert(Connectivity == 4 || Connectivity == 8, "Connectivity must be 4 or 8");
     std::vector<Segment> result;
-    std::vector<std::vector<unsigned int>> segmentsMatrix;
 
     unsigned int currentSegmentID = 0;
 
-    for(auto k : pixels){
-        segmentsMatrix.emplace_back(std::vector<unsigned int>());
-        for( auto j : k){
-            segmentsMatrix.back().emplace_back(0);
-        }
-    }
+    unsigned int maxHeight = pixels.rows();
+    unsigned int maxWidth = pixels.cols();
 
-    unsigned int maxHeight = pixels.size();
-    unsigned int maxWidth = pixels[0].size();
+    std::vector<std::vector<unsigned int>> segmentsMatrix(maxHeight, std::vector<unsigned int>(maxWidth, 0));
+
+    for (unsigned int row = 0; row<maxHeight; ++row){
+        const uint64_t* words = pixels.row(row);
+        for (size_t w = 0; w < pixels.wordsInRow(); ++w){
+            // skip whole words without chosen pixels
+            uint64_t word = words[w];
+            while (word != 0){
+                unsigned int col = static_cast<unsigned int>(w * PackedPixelsMap::WORD_BITS) + __builtin_ctzll(word);
+                word &= word - 1;
+
+                // if pixel don't belong to any segment start flood fill
+                if (segmentsMatrix[row][col] != 0){
+                    continue;
+                }
 
-    for (unsigned int row = 0; row<pixels.size(); ++row){
-        for (unsigned int col = 0; col < pixels[row].size(); ++col){
-            // if pixel was picked and don't belong to any segment start flood fill
-            if(pixels[row][col] && segmentsMatrix[row][col] == 0 ){
                 ++currentSegmentID;
 
                 std::list<PixelPos> segmentPixels;
@@ -67,7 +96,7 @@ std::vector<Segment> findSegments(const PixelsMap& pixels){
                     pixelQueue.pop();
 
 
-                    if(pixels[current.first][current.second] && segmentsMatrix[current.first][current.second] == 0){
+                    if(pixels.get(current.first, current.second) && segmentsMatrix[current.first][current.second] == 0){
                         // two operations:
                         // - set as a current segment ID in segmentsMatrix
                         // - push to segmentPixels
@@ -80,28 +109,40 @@ std::vector<Segment> findSegments(const PixelsMap& pixels){
 
                     // left
                     if(current.first > 0){
-                        if(pixels[current.first-1][current.second] && segmentsMatrix[current.first-1][current.second] == 0){
+                        if(pixels.get(current.first-1, current.second) && segmentsMatrix[current.first-1][current.second] == 0){
                             pixelQueue.emplace(std::make_pair(current.first-1, current.second));
                         }
                     }
                     // right
                     if(current.first + 1 < maxHeight ){
-                        if(pixels[current.first+1][current.second] && segmentsMatrix[current.first+1][current.second] == 0){
+                        if(pixels.get(current.first+1, current.second) && segmentsMatrix[current.first+1][current.second] == 0){
                             pixelQueue.emplace(std::make_pair(current.first+1, current.second));
                         }
                     }
                     // bottom
                     if(current.second > 0){
-                        if(pixels[current.first][current.second-1] && segmentsMatrix[current.first][current.second-1] == 0){
+                        if(pixels.get(current.first, current.second-1) && segmentsMatrix[current.first][current.second-1] == 0){
                             pixelQueue.emplace(std::make_pair(current.first, current.second-1));
                         }
                     }
                     // top
                     if(current.second + 1 < maxWidth ){
-                        if(pixels[current.first][current.second+1] && segmentsMatrix[current.first][current.second+1] == 0){
+                        if(pixels.get(current.first, current.second+1) && segmentsMatrix[current.first][current.second+1] == 0){
                             pixelQueue.emplace(std::make_pair(current.first, current.second+1));
                         }
                     }
+                    // corners
+                    if(Connectivity == 8){
+                        for(int dr : {-1, 1}){
+                            for(int dc : {-1, 1}){
+                                long r = static_cast<long>(current.first) + dr;
+                                long c = static_cast<long>(current.second) + dc;
+                                if(r >= 0 && c >= 0 && r < maxHeight && c < maxWidth && pixels.get(r, c) && segmentsMatrix[r][c] == 0){
+                                    pixelQueue.emplace(std::make_pair(static_cast<unsigned int>(r), static_cast<unsigned int>(c)));
+                                }
+                            }
+                        }
+                    }
                 }
 
                 Segment resultSeg;
@@ -115,12 +156,179 @@ std::vector<Segment> findSegments(const PixelsMap& pixels){
     return result;
 };
 
+/**
+ * @brief segmentsFromLabels Gather pixels of each labelled component, pixels are ordered
+ * row by row.
+ * @param pixels Map of chosen pixels.
+ * @param labels Label image of pixels map.
+ * @return Vector of segments, ID is label.
+ */
+inline std::vector<Segment> segmentsFromLabels(const PackedPixelsMap& pixels, const LabelImage& labels){
+    std::vector<Segment> result(labels.count);
+    for (unsigned int id = 0; id < labels.count; ++id){
+        result[id].id = id + 1;
+    }
+
+    for (int row = 0; row < labels.rows; ++row){
+        const uint64_t* words = pixels.row(row);
+        const uint32_t* current = labels.row(row);
+        for (size_t w = 0; w < pixels.wordsInRow(); ++w){
+            uint64_t word = words[w];
+            while (word != 0){
+                unsigned int col = static_cast<unsigned int>(w * PackedPixelsMap::WORD_BITS) + __builtin_ctzll(word);
+                word &= word - 1;
+                result[current[col] - 1].pixels.emplace_back(static_cast<unsigned int>(row), col);
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief findSegmentsParallel Find segments in given pixels map, strips of rows are labelled
+ * by separate threads and merged along their borders. Result is the same as from findSegments.
+ * @param pixels Map of chosen pixels.
+ * @return Vector of segments.
+ */
+template <int Connectivity = 4>
+std::vector<Segment> findSegmentsParallel(const PackedPixelsMap& pixels){
+    LEGO_PROFILE_STAGE("find_segments", pixels.size() * pixels.cols());
+    LabelImage labels = labelComponentsParallel<Connectivity>(pixels);
+    LEGO_PROFILE_MEMORY(labels.labels.size() * sizeof(uint32_t));
+    LEGO_PROFILE_COUNT("segments", labels.count);
+    return segmentsFromLabels(pixels, labels);
+}
+
+/**
+ * @brief The LabellingAlgorithm enum - algorithm used by findSegments, all of them give
+ * the same segments.
+ * PIXELS - two pass labelling of pixels, strips are labelled in parallel if more than one
+ * thread is set.
+ * BLOCKS - two pass labelling of blocks of two pixels of column.
+ * FLOOD_FILL - breadth first flood fill.
+ */
+enum class LabellingAlgorithm{
+    PIXELS,
+    BLOCKS,
+    FLOOD_FILL
+};
+
+/**
+ * @brief findSegments Find segments in given pixels map using two pass labelling.
+ * Segments and their IDs are the same as from findSegmentsFloodFill, segment pixels
+ * are ordered row by row. If more than one thread is set, pixels labelling uses
+ * findSegmentsParallel.
+ * @param pixels Map of chosen pixels.
+ * @param algorithm Labelling algorithm.
+ * @return Vector of segments.
+ */
+template <int Connectivity = 4>
+std::vector<Segment> findSegments(const PackedPixelsMap& pixels,
+                                  LabellingAlgorithm algorithm = LabellingAlgorithm::PIXELS){
+    if (algorithm == LabellingAlgorithm::FLOOD_FILL){
+        return findSegmentsFloodFill<Connectivity>(pixels);
+    }
+    if (algorithm == LabellingAlgorithm::PIXELS && getThreadsNumber() > 1){
+        return findSegmentsParallel<Connectivity>(pixels);
+    }
+
+    LEGO_PROFILE_STAGE("find_segments", pixels.size() * pixels.cols());
+    LabelImage labels = algorithm == LabellingAlgorithm::BLOCKS ? labelComponentsBlocks<Connectivity>(pixels)
+                                                                : labelComponents<Connectivity>(pixels);
+    LEGO_PROFILE_MEMORY(labels.labels.size() * sizeof(uint32_t));
+    LEGO_PROFILE_COUNT("segments", labels.count);
+    return segmentsFromLabels(pixels, labels);
+}
+
+/**
+ * @brief findRunSegments Find segments in given pixels map as runs of pixels. Segments and
+ * their IDs are the same as from findSegments.
+ * @param pixels Map of chosen pixels.
+ * @return Vector of run length segments.
+ */
+template <int Connectivity = 4>
+std::vector<RunSegment> findRunSegments(const PackedPixelsMap& pixels){
+    LEGO_PROFILE_STAGE("find_segments", pixels.size() * pixels.cols());
+    RunLabelling labelling = labelRuns<Connectivity>(pixels);
+    LEGO_PROFILE_MEMORY(labelling.runs.size() * (sizeof(PixelRun) + sizeof(uint32_t)));
+    LEGO_PROFILE_COUNT("segments", labelling.count);
+
+    std::vector<RunSegment> result(labelling.count);
+    for (unsigned int id = 0; id < labelling.count; ++id){
+        result[id].id = id + 1;
+    }
+
+    for (size_t i = 0; i < labelling.runs.size(); ++i){
+        result[labelling.labels[i] - 1].runs.emplace_back(labelling.runs[i]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief The ClassSegment struct - run length segment of pixels of one class.
+ */
+struct ClassSegment{
+    unsigned int classId;
+    RunSegment segment;
+};
+
+/**
+ * @brief findClassSegments Find segments of each class. Classes are labelled separately,
+ * so pixel that belongs to two classes is in segments of both of them.
+ * @param classMaps Map of chosen pixels for each class, index is class ID.
+ * @return Vector of segments tagged with class, ordered by class, then by ID - IDs of each
+ * class are the same as from findRunSegments for its map.
+ */
+inline std::vector<ClassSegment> findClassSegments(const std::vector<PackedPixelsMap>& classMaps){
+    std::vector<ClassSegment> result;
+    for (size_t c = 0; c < classMaps.size(); ++c){
+        for (auto& segment : findRunSegments(classMaps[c])){
+            result.push_back({static_cast<unsigned int>(c), std::move(segment)});
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief findSegmentStats Find statistics of segments in given pixels map, pixels of segments
+ * are not stored. Segments and their IDs are the same as from findSegments. If more than one
+ * thread is set, strips of rows are scanned in parallel, result is the same.
+ * @param pixels Map of chosen pixels.
+ * @return Vector of segments statistics.
+ */
+template <int Connectivity = 4>
+std::vector<SegmentStats> findSegmentStats(const PackedPixelsMap& pixels){
+    LEGO_PROFILE_STAGE("find_segments", pixels.size() * pixels.cols());
+    std::vector<SegmentStats> result = getThreadsNumber() > 1 ? labelStatsParallel<Connectivity>(pixels)
+                                                              : labelStats<Connectivity>(pixels);
+    LEGO_PROFILE_COUNT("segments", result.size());
+    return result;
+}
+
+/**
+ * @brief runSegmentToSegment Convert run length segment to segment with list of pixels.
+ * @param segment Run length segment.
+ * @return Segment with pixels ordered row by row.
+ */
+inline Segment runSegmentToSegment(const RunSegment& segment){
+    Segment result;
+    result.id = segment.id;
+    for (auto& run : segment.runs){
+        for (unsigned int col = run.colStart; col < run.colEnd; ++col){
+            result.pixels.emplace_back(run.row, col);
+        }
+    }
+    return result;
+}
+
 /**
  * @brief colorSegmentsWithRandomColor Take random color for each segment and color with it segment pixels.
  * @param img Image in which will be placed segment pixels.
  * @param segments Vector of segments.
  */
-void colorSegmentsWithRandomColor(cv::Mat& img, const std::vector<Segment>& segments){
+inline void colorSegmentsWithRandomColor(cv::Mat& img, const std::vector<Segment>& segments){
     cv::Mat_<cv::Vec3b> iter = img;
 
     for(auto seg : segments){
@@ -138,6 +346,26 @@ void colorSegmentsWithRandomColor(cv::Mat& img, const std::vector<Segment>& segm
     }
 }
 
+/**
+ * @brief colorSegmentsWithRandomColor Take random color for each segment and color with it segment runs.
+ * @param img Image in which will be placed segment pixels.
+ * @param segments Vector of run length segments.
+ */
+inline void colorSegmentsWithRandomColor(cv::Mat& img, const std::vector<RunSegment>& segments){
+    for(auto& seg : segments){
+        // generate ranodm color
+        uint8_t b = rand()%std::numeric_limits<uint8_t>::max();
+        uint8_t g = rand()%std::numeric_limits<uint8_t>::max();
+        uint8_t r = rand()%std::numeric_limits<uint8_t>::max();
+
+        // color segment runs
+        for(auto& run : seg.runs){
+            cv::Vec3b* row = img.ptr<cv::Vec3b>(run.row);
+            std::fill(row + run.colStart, row + run.colEnd, cv::Vec3b(b, g, r));
+        }
+    }
+}
+
 /**
  * @brief removeAdditionalSegments Simple function that removes big and small segments.
  * @param min_size Minimal size of segment.
@@ -145,7 +373,8 @@ void colorSegmentsWithRandomColor(cv::Mat& img, const std::vector<Segment>& segm
  * @param original Vector of segments to chose.
  * @return Vector with subset of segments from original.
  */
-std::vector<Segment> removeAdditionalSegments(int min_size, const std::vector<Segment>& original){
+inline std::vector<Segment> removeAdditionalSegments(int min_size, const std::vector<Segment>& original){
+    LEGO_PROFILE_STAGE("remove_segments", 0);
     std::vector<Segment> result;
 
     for (auto s : original){
@@ -154,6 +383,47 @@ std::vector<Segment> removeAdditionalSegments(int min_size, const std::vector<Se
         }
     }
 
+    LEGO_PROFILE_COUNT("chosen_segments", result.size());
+    return result;
+}
+
+/**
+ * @brief removeAdditionalSegments Simple function that removes small run length segments.
+ * @param min_size Minimal size of segment.
+ * @param original Vector of segments to chose.
+ * @return Vector with subset of segments from original.
+ */
+inline std::vector<RunSegment> removeAdditionalSegments(int min_size, const std::vector<RunSegment>& original){
+    LEGO_PROFILE_STAGE("remove_segments", 0);
+    std::vector<RunSegment> result;
+
+    for (auto& s : original){
+        if(s.size() > static_cast<size_t>(min_size)){
+            result.push_back(s);
+        }
+    }
+
+    LEGO_PROFILE_COUNT("chosen_segments", result.size());
+    return result;
+}
+
+/**
+ * @brief removeAdditionalSegments Simple function that removes small segments using their statistics.
+ * @param min_size Minimal size of segment.
+ * @param original Vector of segments statistics to chose.
+ * @return Vector with subset of segments statistics from original.
+ */
+inline std::vector<SegmentStats> removeAdditionalSegments(int min_size, const std::vector<SegmentStats>& original){
+    LEGO_PROFILE_STAGE("remove_segments", 0);
+    std::vector<SegmentStats> result;
+
+    for (auto& s : original){
+        if(s.count > static_cast<size_t>(min_size)){
+            result.push_back(s);
+        }
+    }
+
+    LEGO_PROFILE_COUNT("chosen_segments", result.size());
     return result;
 }
 
@@ -163,7 +433,7 @@ std::vector<Segment> removeAdditionalSegments(int min_size, const std::vector<Se
  * @param segment Segment for which will be found points.
  * @return Vector of points listed above.
  */
-std::vector<unsigned int> segmentBoundingRectPoints(const Segment& segment) {
+inline std::vector<unsigned int> segmentBoundingRectPoints(const Segment& segment) {
     unsigned int most_x= 0;
     unsigned int least_x = std::numeric_limits<unsigned int>::max();
     unsigned int most_y = 0;
@@ -188,13 +458,43 @@ std::vector<unsigned int> segmentBoundingRectPoints(const Segment& segment) {
 }
 
 /**
- * @brief drawBoundingRectForSegment Draw segment bounding rectange in given image.
+ * @brief segmentBoundingRectPoints Find points that describe run length segment - least x,
+ * most x, least y, most y. Only ends of runs are checked.
+ * @param segment Segment for which will be found points.
+ * @return Vector of points listed above.
+ */
+inline std::vector<unsigned int> segmentBoundingRectPoints(const RunSegment& segment) {
+    unsigned int most_x= 0;
+    unsigned int least_x = std::numeric_limits<unsigned int>::max();
+    unsigned int most_y = 0;
+    unsigned int least_y = std::numeric_limits<unsigned int>::max();
+
+    for (auto& run : segment.runs){
+        most_x = std::max(most_x, run.row);
+        least_x = std::min(least_x, run.row);
+        most_y = std::max(most_y, run.colEnd - 1);
+        least_y = std::min(least_y, run.colStart);
+    }
+
+    return { least_x, most_x, least_y, most_y };
+}
+
+/**
+ * @brief segmentBoundingRectPoints Take points that describe segment from its statistics - least x,
+ * most x, least y, most y.
+ * @param segment Segment statistics.
+ * @return Vector of points listed above.
+ */
+inline std::vector<unsigned int> segmentBoundingRectPoints(const SegmentStats& segment) {
+    return { segment.minRow, segment.maxRow, segment.minCol, segment.maxCol };
+}
+
+/**
+ * @brief drawBoundingRect Draw bounding rectange given by its points in given image.
  * @param img Image in which will be draw bounding rectangle.
- * @param segment Segment to draw in image.
+ * @param points Bounding points - least x, most x, least y, most y.
  */
-void drawBoundingRectForSegment(cv::Mat& img, const Segment& segment){
-    // take bounding points
-    std::vector<unsigned int> points = segmentBoundingRectPoints(segment);
+inline void drawBoundingRect(cv::Mat& img, const std::vector<unsigned int>& points){
     std::pair<unsigned int, unsigned int> top_left = std::make_pair(points[0], points[2]);
     std::pair<unsigned int, unsigned int> top_right = std::make_pair(points[1], points[2]);
     std::pair<unsigned int, unsigned int> bottom_left = std::make_pair(points[0], points[3]);
@@ -244,6 +544,33 @@ void drawBoundingRectForSegment(cv::Mat& img, const Segment& segment){
 
 }
 
+/**
+ * @brief drawBoundingRectForSegment Draw segment bounding rectange in given image.
+ * @param img Image in which will be draw bounding rectangle.
+ * @param segment Segment to draw in image.
+ */
+inline void drawBoundingRectForSegment(cv::Mat& img, const Segment& segment){
+    drawBoundingRect(img, segmentBoundingRectPoints(segment));
+}
+
+/**
+ * @brief drawBoundingRectForSegment Draw run length segment bounding rectange in given image.
+ * @param img Image in which will be draw bounding rectangle.
+ * @param segment Segment to draw in image.
+ */
+inline void drawBoundingRectForSegment(cv::Mat& img, const RunSegment& segment){
+    drawBoundingRect(img, segmentBoundingRectPoints(segment));
+}
+
+/**
+ * @brief drawBoundingRectForSegment Draw segment bounding rectange, taken from segment statistics, in given image.
+ * @param img Image in which will be draw bounding rectangle.
+ * @param segment Segment statistics.
+ */
+inline void drawBoundingRectForSegment(cv::Mat& img, const SegmentStats& segment){
+    drawBoundingRect(img, segmentBoundingRectPoints(segment));
+}
+
 
 
 #endif // SEGMENTATION_HPP
@@ -0,0 +1,44 @@
+/**
+  * Runtime detection of instruction sets used by vectorized kernels. Kernels are compiled
+  * with target attributes, so binary don't need to be built with -mavx2.
+  */
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEGO_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief The SimdLevel enum - instruction sets used by vectorized kernels.
+ */
+enum class SimdLevel{
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+/**
+ * @brief detectSimdLevel Check (by CPUID) best instruction set supported by processor.
+ * @return Best supported SimdLevel.
+ */
+inline SimdLevel detectSimdLevel(){
+#ifdef LEGO_SIMD
+    static const SimdLevel level = [](){
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")){
+            return SimdLevel::AVX2;
+        } else if (__builtin_cpu_supports("sse4.1")){
+            return SimdLevel::SSE41;
+        }
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+#endif // SIMD_HPP
@@ -15,6 +15,11 @@
 
 // lego
 #include "PixelPicker.hpp"
+#include "rank_filter_simd.hpp"
+#include "parallel.hpp"
+#include "packed_pixels_map.hpp"
+#include "color_lut.hpp"
+#include "profiler.hpp"
 
 const int DEFUALT_RANK_FILTER_WIDTH = 5;
 const int DEFUALT_RANK_FILTER_HEIGHT = 5;
@@ -40,8 +45,6 @@ const std::vector<std::string> TEST_FILES_NAMES = {
     "gazeta3_3.JPG"
 };
 
-using PixelsMap = std::vector<std::vector<bool>>;
-
 const std::string BLUEST_QUOTE =std::string("We are on a mission from God!");
 
 /**
@@ -53,57 +56,24 @@ const std::string BLUEST_QUOTE =std::string("We are on a mission from God!");
  * is choose as a new value in result image.
  * @return Converted image.
  */
-cv::Mat rankFilter(const cv::Mat& img, int width, int height, unsigned int rank){
-    // check arguments
-    if(width<0 || height<0){
-        throw std::runtime_error("");
-    }
-    else if(rank>=static_cast<unsigned int>(width*height)){
-        throw std::runtime_error("Wrong rank value!");
-    }
-    else if(height%2 == 0 || width%2 == 0){
-        throw std::runtime_error("Filter size not odd!");
-    }
-
-    // create copy
-    cv::Mat res(img.rows, img.cols, CV_8UC3);
-
-    // get iterators
-    cv::Mat_<cv::Vec3b> new_iter = res;
-    cv::Mat_<cv::Vec3b> original_iter = img;
-
-    for (int i = 0; i < img.rows ; ++i){
-        for (int j = 0; j < img.cols; ++j) {
-
-            // copy not change pixels
-            if (i < (height / 2) || i>= (img.rows - height / 2) || j < (width / 2) || j>=(img.cols - width / 2)){
-                new_iter(i, j)[0] = original_iter(i, j)[0];
-                new_iter(i, j)[1] = original_iter(i, j)[1];
-                new_iter(i, j)[2] = original_iter(i, j)[2];
-            }
-            // execute filter for other pixels
-            else {
-                std::vector<std::pair<float, std::pair<int, int>>> vec;
-                for (int row = i - height/2; row<=i + height/2; ++row)
-                {
-                    for (int col = j - width / 2; col <= j + width / 2; ++col) {
-                        double c = (original_iter(row, col)[0] + original_iter(row, col)[1] + original_iter(row, col)[2]) / 3.0;
-                        vec.emplace_back(std::pair<double, std::pair<int, int>>(c, std::pair<int, int>(row, col)));
-                    }
-                }
-
-                std::sort(vec.begin(), vec.end(),
-                    [](const std::pair<double, std::pair<int, int>>&a, const std::pair<double, std::pair<int, int>>&b) -> bool{
-                    return a.first < b.first;});
-
-                new_iter(i, j)[0] = original_iter(vec[rank].second.first, vec[rank].second.second)[0];
-                new_iter(i, j)[1] = original_iter(vec[rank].second.first, vec[rank].second.second)[1];
-                new_iter(i, j)[2] = original_iter(vec[rank].second.first, vec[rank].second.second)[2];
-            }
+inline cv::Mat rankFilter(const cv::Mat& img, int width, int height, unsigned int rank){
+    LEGO_PROFILE_STAGE("rank_filter", img.total());
+    // result image and brightness plane
+    LEGO_PROFILE_MEMORY(img.total() * (3 + sizeof(uint16_t)));
+
+    // small square windows - vectorized sorting networks
+    if (width == height){
+        switch (width){
+        case 3:
+            return rankFilterSimd<3>(img, rank);
+        case 5:
+            return rankFilterSimd<5>(img, rank);
+        case 7:
+            return rankFilterSimd<7>(img, rank);
         }
     }
 
-    return res;
+    return rankFilterHistogram(img, width, height, rank);
 }
 
 /**
@@ -112,30 +82,26 @@ cv::Mat rankFilter(const cv::Mat& img, int width, int height, unsigned int rank)
  * @param pp Pixel validator.
  * @return Pixel map of true and false values.
  */
-PixelsMap pickPixels(const cv::Mat& img, const PixelPicker& pp){
+inline PackedPixelsMap pickPixels(const cv::Mat& img, const PixelPicker& pp){
     // get iterator
     cv::Mat_<cv::Vec3f> original_iter = img;
 
-    PixelsMap pixelsMap(img.rows);
+    PackedPixelsMap pixelsMap(img.rows, img.cols);
 
-    for (int i = 0; i < img.rows ; ++i){
-        for (int j = 0; j < img.cols; ++j) {
-            if(pp.isCorrectPixel(original_iter(i, j)[0], original_iter(i, j)[1], original_iter(i, j)[2])){
-                pixelsMap[i].emplace_back(true);
-                //pixels.emplace(cv::Point2i(i, j));
-            }else{
-                pixelsMap[i].emplace_back(false);
-            }
+    // one classifyRow call for each row
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            pp.classifyRow(original_iter.ptr<float>(i), static_cast<size_t>(img.cols), pixelsMap.row(i));
         }
-    }
-
+    });
 
     return pixelsMap;
 }
 
 
 /**
- * @brief neighbourAwarePixelPicker Pick pixel using local information.
+ * @brief neighbourAwarePixelPickerBruteForce Pick pixel using local information, reference
+ * version that checks each pixel of neighbours window.
  * @param img Soucre image.
  * @param pp Pixel validator.
  * @param width Width of neighbours window.
@@ -143,7 +109,7 @@ PixelsMap pickPixels(const cv::Mat& img, const PixelPicker& pp){
  * @param percent Percent of chosen pixel in  neighbours window.
  * @return Pixels map of rue and flase values.
  */
-PixelsMap neighbourAwarePixelPicker(const cv::Mat& img, const PixelPicker& pp, int width, int height, float percent){
+inline PackedPixelsMap neighbourAwarePixelPickerBruteForce(const cv::Mat& img, const PixelPicker& pp, int width, int height, float percent){
     // check arguments
     if(width<0 || height<0){
         throw std::runtime_error("");
@@ -152,45 +118,293 @@ PixelsMap neighbourAwarePixelPicker(const cv::Mat& img, const PixelPicker& pp, i
         throw std::runtime_error("Filter size not odd!");
     }
 
-    cv::Mat_<cv::Vec3b> original_iter = img;
+    // channels are read as 8 bit values, then given to pixel validator as floats
+    cv::Mat_<cv::Vec3f> original_iter = cv::Mat(cv::Mat_<cv::Vec3b>(img));
 
-    PixelsMap pixelsMap(img.rows);
+    PackedPixelsMap pixelsMap(img.rows, img.cols);
 
 
-    for (int i = 0; i < img.rows ; ++i){
-        for (int j = 0; j < img.cols; ++j) {
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        std::vector<uint64_t> bits((width + PackedPixelsMap::WORD_BITS - 1) / PackedPixelsMap::WORD_BITS);
 
-            // copy not change pixels
-            if (i < (height / 2) || i>= (img.rows - height / 2) || j < (width / 2) || j>=(img.cols - width / 2)){
-                pixelsMap[i].emplace_back(false);
-                continue;
-            }
-            // execute filter for other pixels
-            else {
-                int num = 0;
-                for (int row = i - height/2; row<=i + height/2; ++row)
-                {
-                    for (int col = j - width / 2; col <= j + width / 2; ++col) {
-                        if(pp.isCorrectPixel(original_iter(row, col)[0], original_iter(row, col)[1], original_iter(row, col)[2])){
-                            ++num;
+        for (int i = begin; i < end ; ++i){
+            for (int j = 0; j < img.cols; ++j) {
+
+                // copy not change pixels
+                if (i < (height / 2) || i>= (img.rows - height / 2) || j < (width / 2) || j>=(img.cols - width / 2)){
+                    continue;
+                }
+                // execute filter for other pixels, each row of window is checked by one call
+                else {
+                    int num = 0;
+                    for (int row = i - height/2; row<=i + height/2; ++row)
+                    {
+                        pp.classifyRow(original_iter.ptr<float>(row) + 3 * (j - width / 2), static_cast<size_t>(width), bits.data());
+                        for (auto word : bits){
+                            num += __builtin_popcountll(word);
                         }
                     }
+
+                    if (static_cast<float>(num)/static_cast<float>(width * height)>percent){
+                        pixelsMap.set(i, j, true);
+                    }
                 }
+            }
+        }
+    }, height / 2);
+    return pixelsMap;
+}
+
+/**
+ * @brief pixelsMask Check each pixel of image once. Image channels are read as
+ * 8 bit values - the same way as in neighbourAwarePixelPickerBruteForce.
+ * @param img Soucre image.
+ * @param pp Pixel validator.
+ * @return One channel CV_8UC1 image, 1 for chosen pixels, 0 otherwise.
+ */
+inline cv::Mat pixelsMask(const cv::Mat& img, const PixelPicker& pp){
+    cv::Mat_<cv::Vec3b> original_iter = img;
+    cv::Mat mask(img.rows, img.cols, CV_8UC1);
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        // buffers for one row - 8 bit values as floats and result bits
+        std::vector<float> colors(3 * static_cast<size_t>(img.cols));
+        std::vector<uint64_t> bits((img.cols + PackedPixelsMap::WORD_BITS - 1) / PackedPixelsMap::WORD_BITS);
+
+        for (int i = begin; i < end ; ++i){
+            const uint8_t* src = original_iter.ptr<uint8_t>(i);
+            std::copy(src, src + colors.size(), colors.begin());
+            pp.classifyRow(colors.data(), static_cast<size_t>(img.cols), bits.data());
+
+            uint8_t* dst = mask.ptr<uint8_t>(i);
+            for (int j = 0; j < img.cols; ++j) {
+                dst[j] = (bits[j / PackedPixelsMap::WORD_BITS] >> (j % PackedPixelsMap::WORD_BITS)) & 1u;
+            }
+        }
+    });
+
+    return mask;
+}
+
+/**
+ * @brief summedAreaTable Count summed-area table of mask.
+ * @param mask One channel CV_8UC1 image.
+ * @return Vector of (mask.rows + 1) * (mask.cols + 1) values, value at [r][c] is
+ * a sum of mask values in rows lower than r and columns lower than c.
+ */
+inline std::vector<uint32_t> summedAreaTable(const cv::Mat& mask){
+    const size_t stride = static_cast<size_t>(mask.cols) + 1;
+    std::vector<uint32_t> table(stride * (mask.rows + 1), 0);
+
+    // prefix sums of each row
+    parallelForRows(0, mask.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            const uint8_t* src = mask.ptr<uint8_t>(i);
+            uint32_t* dst = &table[(i + 1) * stride];
+            for (int j = 0; j < mask.cols; ++j) {
+                dst[j + 1] = dst[j] + src[j];
+            }
+        }
+    });
+
+    // accumulate rows
+    for (int i = 1; i <= mask.rows ; ++i){
+        uint32_t* prev = &table[(i - 1) * stride];
+        uint32_t* dst = &table[i * stride];
+        for (size_t j = 1; j < stride; ++j) {
+            dst[j] += prev[j];
+        }
+    }
+
+    return table;
+}
+
+/**
+ * @brief checkNeighbourWindow Check size of neighbours window.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ */
+inline void checkNeighbourWindow(int width, int height){
+    if(width<0 || height<0){
+        throw std::runtime_error("");
+    }
+    else if(height%2 == 0 || width%2 == 0){
+        throw std::runtime_error("Filter size not odd!");
+    }
+}
+
+/**
+ * @brief neighbourAwareMaskPicker Pick pixel if percent of chosen pixels of mask in its
+ * neighbours window is big enough. Number of chosen pixels in window is taken from
+ * summed-area table, so cost doesn't depend on window size.
+ * @param mask One channel CV_8UC1 image, 1 for chosen pixels, 0 otherwise.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel in  neighbours window.
+ * @return Pixels map of rue and flase values.
+ */
+inline PackedPixelsMap neighbourAwareMaskPicker(const cv::Mat& mask, int width, int height, float percent){
+    checkNeighbourWindow(width, height);
+
+    std::vector<uint32_t> table = summedAreaTable(mask);
+    const size_t stride = static_cast<size_t>(mask.cols) + 1;
+
+    PackedPixelsMap pixelsMap(mask.rows, mask.cols);
+    LEGO_PROFILE_MEMORY(table.size() * sizeof(uint32_t) + pixelsMap.stride() * pixelsMap.rows() * sizeof(uint64_t));
+
+    parallelForRows(height / 2, mask.rows - height / 2, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            const uint32_t* top = &table[(i - height / 2) * stride];
+            const uint32_t* bottom = &table[(i + height / 2 + 1) * stride];
+            uint64_t* dst = pixelsMap.row(i);
+            for (int j = width / 2; j < mask.cols - width / 2; ++j) {
+                uint32_t num = bottom[j + width / 2 + 1] - bottom[j - width / 2]
+                        - top[j + width / 2 + 1] + top[j - width / 2];
 
                 if (static_cast<float>(num)/static_cast<float>(width * height)>percent){
-                    pixelsMap[i].emplace_back(true);
-                } else{
-                    pixelsMap[i].emplace_back(false);
+                    dst[j / PackedPixelsMap::WORD_BITS] |= uint64_t(1) << (j % PackedPixelsMap::WORD_BITS);
                 }
             }
         }
-    }
+    });
+
     return pixelsMap;
 }
+
+/**
+ * @brief neighbourAwarePixelPicker Pick pixel using local information. Each pixel is checked
+ * once, then number of chosen pixels in window is taken from summed-area table, so cost
+ * doesn't depend on window size. Result is the same as from neighbourAwarePixelPickerBruteForce.
+ * @param img Soucre image.
+ * @param pp Pixel validator.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel in  neighbours window.
+ * @return Pixels map of rue and flase values.
+ */
+inline PackedPixelsMap neighbourAwarePixelPicker(const cv::Mat& img, const PixelPicker& pp, int width, int height, float percent){
+    checkNeighbourWindow(width, height);
+    LEGO_PROFILE_STAGE("neighbour_picker", img.total());
+    LEGO_PROFILE_MEMORY(img.total());
+    return neighbourAwareMaskPicker(pixelsMask(img, pp), width, height, percent);
+}
+
+/**
+ * @brief neighbourAwarePixelPicker Pick pixel using local information, pixels are classified
+ * straight from BGR image by lookup table. With table compiled from picker with BYTE_CHANNELS,
+ * result is the same as from neighbourAwarePixelPicker for image converted by cvtImgColorsToGIMPHSV.
+ * @param img Soucre BGR image.
+ * @param lut Lookup table of chosen colors.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel in  neighbours window.
+ * @return Pixels map of rue and flase values.
+ */
+inline PackedPixelsMap neighbourAwarePixelPicker(const cv::Mat& img, const ColorLUT& lut, int width, int height, float percent){
+    checkNeighbourWindow(width, height);
+    LEGO_PROFILE_STAGE("neighbour_picker", img.total());
+    LEGO_PROFILE_MEMORY(img.total());
+    return neighbourAwareMaskPicker(pixelsMask(img, lut), width, height, percent);
+}
+
+/**
+ * @brief classMasks Check each pixel of image once by ranges of all classes. Image channels
+ * are read as 8 bit values - the same way as in pixelsMask.
+ * @param img Soucre image.
+ * @param pp Multi class pixel validator.
+ * @return One channel CV_16UC1 image, bit c of pixel is set if it belongs to class c.
+ */
+inline cv::Mat classMasks(const cv::Mat& img, const MultiClassPixelPicker& pp){
+    cv::Mat_<cv::Vec3b> original_iter = img;
+    cv::Mat masks(img.rows, img.cols, CV_16UC1);
+
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        // buffers for one row - 8 bit values as floats and bits of one class
+        std::vector<float> colors(3 * static_cast<size_t>(img.cols));
+        std::vector<uint64_t> classBits((img.cols + PackedPixelsMap::WORD_BITS - 1) / PackedPixelsMap::WORD_BITS);
+
+        for (int i = begin; i < end ; ++i){
+            const uint8_t* src = original_iter.ptr<uint8_t>(i);
+            std::copy(src, src + colors.size(), colors.begin());
+            pp.classifyRowClasses(colors.data(), static_cast<size_t>(img.cols), masks.ptr<uint16_t>(i), classBits.data());
+        }
+    });
+
+    return masks;
+}
+
+/**
+ * @brief neighbourAwareMultiClassPicker Pick pixels of each class using local information.
+ * Image is classified once for all classes, then windows of all classes are counted in one
+ * pass over class masks: each band of rows keeps number of chosen pixels of each class in
+ * window rows of each column, rows are added when window enters them and removed when it
+ * leaves them. Result of each class is the same as from neighbourAwarePixelPicker with
+ * HSVPixelPicker of that class.
+ * @param img Soucre image.
+ * @param pp Multi class pixel validator.
+ * @param width Width of neighbours window.
+ * @param height Height of neighbours window.
+ * @param percent Percent of chosen pixel of class in neighbours window.
+ * @return Pixels map for each class, index is class ID.
+ */
+inline std::vector<PackedPixelsMap> neighbourAwareMultiClassPicker(const cv::Mat& img, const MultiClassPixelPicker& pp,
+                                                                   int width, int height, float percent){
+    checkNeighbourWindow(width, height);
+
+    const cv::Mat masks = classMasks(img, pp);
+    const size_t classes = pp.classesNumber();
+    const size_t cols = static_cast<size_t>(img.cols);
+
+    std::vector<PackedPixelsMap> result;
+    for (size_t c = 0; c < classes; ++c){
+        result.emplace_back(img.rows, img.cols);
+    }
+    LEGO_PROFILE_MEMORY(img.total() * sizeof(uint16_t) + classes * result[0].stride() * img.rows * sizeof(uint64_t));
+
+    parallelForRows(height / 2, img.rows - height / 2, [&](int begin, int end){
+        // number of chosen pixels of class c in window rows of column j is at c * cols + j
+        std::vector<uint32_t> columns(classes * cols, 0);
+        auto addRow = [&](int row, uint32_t delta){
+            const uint16_t* src = masks.ptr<uint16_t>(row);
+            for (size_t j = 0; j < cols; ++j){
+                // only classes of pixel are visited, delta -1 removes row
+                for (unsigned int mask = src[j]; mask != 0; mask &= mask - 1){
+                    columns[__builtin_ctz(mask) * cols + j] += delta;
+                }
+            }
+        };
+
+        for (int row = begin - height / 2; row < begin + height / 2; ++row){
+            addRow(row, 1);
+        }
+        for (int i = begin; i < end ; ++i){
+            addRow(i + height / 2, 1);
+            for (size_t c = 0; c < classes; ++c){
+                const uint32_t* column = &columns[c * cols];
+                uint64_t* dst = result[c].row(i);
+                uint32_t num = 0;
+                for (int j = 0; j < width - 1 && j < img.cols; ++j){
+                    num += column[j];
+                }
+                for (int j = width / 2; j < img.cols - width / 2; ++j) {
+                    num += column[j + width / 2];
+                    if (static_cast<float>(num)/static_cast<float>(width * height)>percent){
+                        dst[j / PackedPixelsMap::WORD_BITS] |= uint64_t(1) << (j % PackedPixelsMap::WORD_BITS);
+                    }
+                    num -= column[j - width / 2];
+                }
+            }
+            addRow(i - height / 2, static_cast<uint32_t>(-1));
+        }
+    }, height / 2);
+
+    return result;
+}
+
 /**
   *
   */
-cv::Mat colorGivenPixelMap(const cv::Mat& img, const PixelsMap& pixelsMap, std::vector<uint8_t> color = {255, 0, 0}){
+inline cv::Mat colorGivenPixelMap(const cv::Mat& img, const PackedPixelsMap& pixelsMap, std::vector<uint8_t> color = {255, 0, 0}){
     // create copy
     cv::Mat res(img.rows, img.cols, CV_8UC3);
 
@@ -199,35 +413,36 @@ cv::Mat colorGivenPixelMap(const cv::Mat& img, const PixelsMap& pixelsMap, std::
     cv::Mat_<cv::Vec3b> original_iter = img;
 
 
-    for (int i = 0; i < img.rows ; ++i){
-        for (int j = 0; j < img.cols; ++j) {
-            if(pixelsMap[i][j]){
-                new_iter(i, j)[0] = color[0];
-                new_iter(i, j)[1] = color[1];
-                new_iter(i, j)[2] = color[2];
-            } else {
-                new_iter(i, j)[0] = original_iter(i,j)[0];
-                new_iter(i, j)[1] = original_iter(i,j)[1];
-                new_iter(i, j)[2] = original_iter(i,j)[2];
+    parallelForRows(0, img.rows, [&](int begin, int end){
+        for (int i = begin; i < end ; ++i){
+            for (int j = 0; j < img.cols; ++j) {
+                if(pixelsMap.get(i, j)){
+                    new_iter(i, j)[0] = color[0];
+                    new_iter(i, j)[1] = color[1];
+                    new_iter(i, j)[2] = color[2];
+                } else {
+                    new_iter(i, j)[0] = original_iter(i,j)[0];
+                    new_iter(i, j)[1] = original_iter(i,j)[1];
+                    new_iter(i, j)[2] = original_iter(i,j)[2];
+                }
             }
         }
-    }
+    });
 
 
     return res;
 }
 /**
- * @brief closing
- * @param pixMap
- * @param width
- * @param height
- * @return
+ * @brief closing Pixel is chosen if any pixel in its window is chosen (dilation), pixels closer
+ * to border than half of window keep their value. Each window is checked pixel by pixel, dilation
+ * from morphology.hpp gives the same result with word operations.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
  */
-PixelsMap closing(const PixelsMap& pixMap, int width, int height){
+inline PackedPixelsMap closing(const PackedPixelsMap& pixMap, int width, int height){
     // check arguments
-
-    PixelsMap copy;
-
     if(width<0 || height<0){
         throw std::runtime_error("");
     }
@@ -235,29 +450,26 @@ PixelsMap closing(const PixelsMap& pixMap, int width, int height){
         throw std::runtime_error("Filter size not odd!");
     }
 
-    for (int i = 0; i < pixMap.size(); ++i){
-        copy.emplace_back(std::vector<bool>());
-        for (int j = 0; j < pixMap[i].size(); ++j) {
+    PackedPixelsMap copy(pixMap.rows(), pixMap.cols());
+
+    for (int i = 0; i < pixMap.rows(); ++i){
+        for (int j = 0; j < pixMap.cols(); ++j) {
 
-            if (!(i < (height / 2) || i>= (pixMap.size()- height / 2) || j < (width / 2) || j>=(pixMap[i].size() - width / 2))){
+            if (!(i < (height / 2) || i>= (pixMap.rows() - height / 2) || j < (width / 2) || j>=(pixMap.cols() - width / 2))){
                 bool found = false;
-                for (int row = i - height/2; row<=i + height/2; ++row){
+                for (int row = i - height/2; row<=i + height/2 && !found; ++row){
                     for (int col = j - width / 2; col <= j + width / 2; ++col) {
-                        if ( pixMap[row][col]){
+                        if (pixMap.get(row, col)){
                             found = true;
                             break;
                         }
                     }
                 }
 
-                if(found){
-                    copy[i].emplace_back(true);
-                } else{
-                    copy[i].emplace_back(false);
-                }
+                copy.set(i, j, found);
 
             } else {
-                copy[i].emplace_back(pixMap[i][j]);
+                copy.set(i, j, pixMap.get(i, j));
             }
         }
     }
@@ -266,11 +478,17 @@ PixelsMap closing(const PixelsMap& pixMap, int width, int height){
 };
 
 
-PixelsMap opening(const PixelsMap& pixMap, int width, int height){
+/**
+ * @brief opening Pixel is chosen if all pixels in its window are chosen (erosion), pixels closer
+ * to border than half of window keep their value. Each window is checked pixel by pixel, erosion
+ * from morphology.hpp gives the same result with word operations.
+ * @param pixMap Map of chosen pixels.
+ * @param width Width of window, odd.
+ * @param height Height of window, odd.
+ * @return Result map.
+ */
+inline PackedPixelsMap opening(const PackedPixelsMap& pixMap, int width, int height){
     // check arguments
-
-    PixelsMap copy;
-
     if(width<0 || height<0){
         throw std::runtime_error("");
     }
@@ -278,29 +496,26 @@ PixelsMap opening(const PixelsMap& pixMap, int width, int height){
         throw std::runtime_error("Filter size not odd!");
     }
 
-    for (int i = 0; i < pixMap.size(); ++i){
-        copy.emplace_back(std::vector<bool>());
-        for (int j = 0; j < pixMap[i].size(); ++j) {
+    PackedPixelsMap copy(pixMap.rows(), pixMap.cols());
 
-            if (!(i < (height / 2) || i>= (pixMap.size()- height / 2) || j < (width / 2) || j>=(pixMap[i].size() - width / 2))){
+    for (int i = 0; i < pixMap.rows(); ++i){
+        for (int j = 0; j < pixMap.cols(); ++j) {
+
+            if (!(i < (height / 2) || i>= (pixMap.rows() - height / 2) || j < (width / 2) || j>=(pixMap.cols() - width / 2))){
                 bool found = false;
-                for (int row = i - height/2; row<=i + height/2; ++row){
+                for (int row = i - height/2; row<=i + height/2 && !found; ++row){
                     for (int col = j - width / 2; col <= j + width / 2; ++col) {
-                        if ( pixMap[row][col] == false){
+                        if (!pixMap.get(row, col)){
                             found = true;
                             break;
                         }
                     }
                 }
 
-                if(found){
-                    copy[i].emplace_back(false);
-                } else{
-                    copy[i].emplace_back(true);
-                }
+                copy.set(i, j, !found);
 
             } else {
-                copy[i].emplace_back(pixMap[i][j]);
+                copy.set(i, j, pixMap.get(i, j));
             }
         }
     }
@@ -315,7 +530,7 @@ PixelsMap opening(const PixelsMap& pixMap, int width, int height){
  * @param img Image to display.
  * @param name Name of display window, default: image.
  */
-void showImgAndWait(const cv::Mat& img, std::string name = "image" ){
+inline void showImgAndWait(const cv::Mat& img, std::string name = "image" ){
     cv::namedWindow( name, cv::WINDOW_NORMAL );
     cv::imshow(name, img);
     cv::waitKey(-1);
@@ -328,7 +543,7 @@ void showImgAndWait(const cv::Mat& img, std::string name = "image" ){
  * @param img Image from which will be taken colors.
  * @param csvName Name of created csv file.
  */
-void saveImgColorsToCSV(const cv::Mat& img, std::string csvName = "colors.csv"){
+inline void saveImgColorsToCSV(const cv::Mat& img, std::string csvName = "colors.csv"){
     std::fstream file(csvName, std::ios::out);
 
     cv::Mat_<cv::Vec3f> original_iter = img;
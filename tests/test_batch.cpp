@@ -0,0 +1,183 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/batch.hpp"
+#include "../src/utils.hpp"
+
+// std
+#include <vector>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <stdexcept>
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+
+TEST_CASE("Tests for BoundedQueue class", "[batch][BoundedQueue]"){
+    SECTION("items are taken in order, queue never exceeds capacity"){
+        BoundedQueue<int> queue(3);
+        const int ITEMS = 1000;
+        size_t maxSize = 0;
+
+        std::thread producer([&queue, ITEMS](){
+            for (int i = 0; i < ITEMS; ++i){
+                queue.push(i);
+            }
+            queue.close();
+        });
+
+        std::vector<int> taken;
+        int item;
+        while (true){
+            maxSize = std::max(maxSize, queue.size());
+            if (!queue.pop(item)){
+                break;
+            }
+            taken.emplace_back(item);
+        }
+        producer.join();
+
+        REQUIRE(taken.size() == ITEMS);
+        for (int i = 0; i < ITEMS; ++i){
+            REQUIRE(taken[i] == i);
+        }
+        REQUIRE(maxSize <= 3);
+    }
+
+    SECTION("closed queue"){
+        BoundedQueue<int> queue(2);
+        REQUIRE(queue.push(1));
+        queue.close();
+        REQUIRE_FALSE(queue.push(2));
+
+        int item = 0;
+        REQUIRE(queue.pop(item));
+        REQUIRE(item == 1);
+        REQUIRE_FALSE(queue.pop(item));
+    }
+}
+
+TEST_CASE("Tests for collectInputFiles function", "[batch][collectInputFiles]"){
+    SECTION("directory and glob pattern"){
+        auto files = collectInputFiles(LEGO_DATA_DIR);
+        REQUIRE(files.size() == TEST_FILES_NAMES.size());
+        REQUIRE(std::is_sorted(files.begin(), files.end()));
+        std::vector<std::string> names;
+        for (auto& file : files){
+            names.emplace_back(fileName(file));
+        }
+        for (auto& name : TEST_FILES_NAMES){
+            REQUIRE(std::count(names.begin(), names.end(), name) == 1);
+        }
+
+        auto pattern = collectInputFiles(std::string(LEGO_DATA_DIR) + "koc_*");
+        REQUIRE(pattern.size() == 3);
+        REQUIRE(fileName(pattern[0]) == "koc_1.JPG");
+    }
+
+    SECTION("manifest file"){
+        std::ofstream manifest("test_batch_manifest.txt");
+        manifest << "# images\n"
+                 << std::string(LEGO_DATA_DIR) + "koc_2.JPG\r\n"
+                 << "\n"
+                 << "  " << std::string(LEGO_DATA_DIR) + "koc_1.JPG  \n"
+                 << "relative.jpg\n";
+        manifest.close();
+
+        auto files = collectInputFiles("test_batch_manifest.txt");
+        REQUIRE(files.size() == 3);
+        REQUIRE(files[0] == std::string(LEGO_DATA_DIR) + "koc_2.JPG");
+        REQUIRE(files[1] == std::string(LEGO_DATA_DIR) + "koc_1.JPG");
+        REQUIRE(files[2] == "relative.jpg");
+
+        REQUIRE_THROWS(collectInputFiles("not_existing_manifest.txt"));
+    }
+
+    SECTION("image extensions"){
+        REQUIRE(isImageFile("a/b/c.JPG"));
+        REQUIRE(isImageFile("c.png"));
+        REQUIRE_FALSE(isImageFile("c.txt"));
+        REQUIRE_FALSE(isImageFile("jpg"));
+    }
+}
+
+TEST_CASE("Tests for runBatch function", "[batch][runBatch]"){
+    SECTION("errors of single images don't stop batch"){
+        std::vector<std::string> files;
+        for (auto& name : TEST_FILES_NAMES){
+            files.emplace_back(std::string(LEGO_DATA_DIR) + name);
+        }
+        files.emplace_back(std::string(LEGO_DATA_DIR) + "not_existing.JPG");
+
+        BatchOptions options;
+        options.workers = 3;
+        options.queueSize = 2;
+
+        size_t reported = 0;
+        auto results = runBatch(files, "test_batch_output", [](const std::string&, cv::Mat& img){
+            img.at<cv::Vec3b>(0, 0) = cv::Vec3b(0, 0, 255);
+        }, options, [&reported](const BatchResult&){ ++reported; });
+
+        REQUIRE(results.size() == files.size());
+        REQUIRE(reported == files.size());
+        for (size_t i = 0; i < TEST_FILES_NAMES.size(); ++i){
+            REQUIRE(results[i].success);
+            REQUIRE(results[i].inputFile == files[i]);
+            REQUIRE(results[i].outputFile == "test_batch_output/" + TEST_FILES_NAMES[i]);
+            REQUIRE(cv::utils::fs::exists(results[i].outputFile));
+        }
+        REQUIRE_FALSE(results.back().success);
+        REQUIRE_FALSE(results.back().error.empty());
+    }
+
+    SECTION("exception of process"){
+        std::vector<std::string> files = {std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0],
+                                          std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[1]};
+        auto results = runBatch(files, "test_batch_output", [](const std::string&, cv::Mat&){
+            throw std::runtime_error("process error");
+        });
+
+        REQUIRE(results.size() == 2);
+        for (auto& result : results){
+            REQUIRE_FALSE(result.success);
+            REQUIRE(result.error == "process error");
+        }
+    }
+
+    SECTION("unknown exception of process"){
+        std::vector<std::string> files = {std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0]};
+        auto results = runBatch(files, "test_batch_output", [](const std::string&, cv::Mat&){
+            throw 42;
+        });
+
+        REQUIRE(results.size() == 1);
+        REQUIRE_FALSE(results[0].success);
+        REQUIRE(results[0].error == "Unknown error");
+    }
+
+    SECTION("same names get unique output files"){
+        std::string file = std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0];
+        std::vector<std::string> files = {file, file, file};
+        auto results = runBatch(files, "test_batch_output", [](const std::string&, cv::Mat&){});
+
+        REQUIRE(results.size() == 3);
+        REQUIRE(results[0].outputFile == "test_batch_output/" + TEST_FILES_NAMES[0]);
+        for (size_t i = 0; i < results.size(); ++i){
+            REQUIRE(results[i].success);
+            REQUIRE(cv::utils::fs::exists(results[i].outputFile));
+            for (size_t j = 0; j < i; ++j){
+                REQUIRE(results[i].outputFile != results[j].outputFile);
+            }
+        }
+    }
+}
+
+TEST_CASE("Tests for outputFilePaths function", "[batch][outputFilePaths]"){
+    std::vector<std::string> files = {"a/img.jpg", "b/img.jpg", "img.jpg", "c/img_2.jpg", "a/noext", "b/noext"};
+    std::vector<std::string> expected = {"out/img.jpg", "out/img_2.jpg", "out/img_3.jpg",
+                                         "out/img_2_2.jpg", "out/noext", "out/noext_2"};
+    REQUIRE(outputFilePaths("out", files) == expected);
+}
@@ -8,6 +8,8 @@
 #include<vector>
 #include<cmath>
 #include<limits>
+#include<algorithm>
+#include<string>
 
 // opencv
 #include <opencv2/opencv.hpp>
@@ -119,3 +121,109 @@ TEST_CASE("Tests for BGR to HSV functions", "[color_cvt][cvtColorBGRToHSV]"){
         }
     }
 }
+
+TEST_CASE("Tests for row BGR to HSV kernels", "[color_cvt][cvtRowBGRToHSV]"){
+    std::vector<SimdLevel> levels = {SimdLevel::SCALAR};
+    if (detectSimdLevel() != SimdLevel::SCALAR){
+        levels.emplace_back(SimdLevel::SSE41);
+    }
+    if (detectSimdLevel() == SimdLevel::AVX2){
+        levels.emplace_back(SimdLevel::AVX2);
+    }
+
+    // row with all colors of few blue values and random colors, length not divisible by 4
+    std::vector<uint8_t> row;
+    for (int b : {0, 1, 17, 128, 254, 255}){
+        for (int g = 0; g < 256; ++g){
+            for (int r = 0; r < 256; ++r){
+                row.insert(row.end(), {static_cast<uint8_t>(b), static_cast<uint8_t>(g), static_cast<uint8_t>(r)});
+            }
+        }
+    }
+    srand(41);
+    for (int i = 0; i < 30001; ++i){
+        row.insert(row.end(), {static_cast<uint8_t>(rand()%256), static_cast<uint8_t>(rand()%256), static_cast<uint8_t>(rand()%256)});
+    }
+    const int n = static_cast<int>(row.size() / 3);
+
+    SECTION("own and OpenCV scales are the same as per pixel functions"){
+        for (auto level : levels){
+            std::vector<uint8_t> own(3 * n), opencv(3 * n), h(n), s(n), v(n);
+            cvtRowBGRToHSV<OwnScale>(row.data(), n, own.data(), level);
+            cvtRowBGRToHSV<OpenCVScale>(row.data(), n, opencv.data(), level);
+            cvtRowBGRToHSVPlanar<OpenCVScale>(row.data(), n, h.data(), s.data(), v.data(), level);
+
+            bool same = true;
+            for (int j = 0; j < n && same; ++j){
+                auto expectedOwn = cvtColorBGRToHSVOwnScale(row[3 * j], row[3 * j + 1], row[3 * j + 2]);
+                auto expectedOpenCV = cvtColorBGRToHSVOpenCVScale(row[3 * j], row[3 * j + 1], row[3 * j + 2]);
+                same = std::equal(expectedOwn.begin(), expectedOwn.end(), own.begin() + 3 * j)
+                        && std::equal(expectedOpenCV.begin(), expectedOpenCV.end(), opencv.begin() + 3 * j)
+                        && expectedOpenCV[0] == h[j] && expectedOpenCV[1] == s[j] && expectedOpenCV[2] == v[j];
+            }
+            REQUIRE(same);
+        }
+    }
+
+    SECTION("GIMP scale is the same as per pixel function"){
+        for (auto level : levels){
+            std::vector<float> gimp(3 * n), h(n), s(n), v(n);
+            cvtRowBGRToHSV<GIMPScale>(row.data(), n, gimp.data(), level);
+            cvtRowBGRToHSVPlanar<GIMPScale>(row.data(), n, h.data(), s.data(), v.data(), level);
+
+            bool same = true;
+            for (int j = 0; j < n && same; ++j){
+                auto expected = cvtColorBGRToHSV(row[3 * j], row[3 * j + 1], row[3 * j + 2]);
+                float eh = static_cast<float>(expected[0]*HUE_SCALE_GIMP);
+                float es = static_cast<float>(expected[1]*SATURATION_SCALE_GIMP);
+                float ev = static_cast<float>(expected[2]*VALUE_SCALE_GIMP);
+                same = gimp[3 * j] == eh && gimp[3 * j + 1] == es && gimp[3 * j + 2] == ev
+                        && h[j] == eh && s[j] == es && v[j] == ev;
+            }
+            REQUIRE(same);
+        }
+    }
+
+    SECTION("GIMP scale doesn't fit in 8 bits"){
+        REQUIRE(hsvScaleFitsByte<OwnScale>());
+        REQUIRE(hsvScaleFitsByte<OpenCVScale>());
+        REQUIRE_FALSE(hsvScaleFitsByte<GIMPScale>());
+    }
+}
+
+TEST_CASE("Tests for cvtImgColors with compile time scale", "[color_cvt][cvtImgColors]"){
+    // each image has all green and red values for one blue value
+    for (int b : {0, 3, 64, 200, 255}){
+        cv::Mat img(256, 256, CV_8UC3);
+        cv::Mat_<cv::Vec3b> m = img;
+        for (int g = 0; g < 256; ++g){
+            for (int r = 0; r < 256; ++r){
+                m(g, r) = cv::Vec3b(static_cast<uint8_t>(b), static_cast<uint8_t>(g), static_cast<uint8_t>(r));
+            }
+        }
+
+        SECTION("own scale is the same as per pixel function, blue " + std::to_string(b)){
+            cv::Mat expected = cvtImgColors(img, &cvtColorBGRToHSVOwnScale);
+            cv::Mat result = cvtImgColors<OwnScale, uint8_t>(img);
+            REQUIRE(result.type() == CV_8UC3);
+            REQUIRE(std::equal(expected.ptr<uint8_t>(0), expected.ptr<uint8_t>(0) + 3 * 256 * 256, result.ptr<uint8_t>(0)));
+        }
+
+        SECTION("OpenCV scale is the same as per pixel function, blue " + std::to_string(b)){
+            cv::Mat expected = cvtImgColors(img, &cvtColorBGRToHSVOpenCVScale);
+            cv::Mat result = cvtImgColors<OpenCVScale, uint8_t>(img);
+            REQUIRE(std::equal(expected.ptr<uint8_t>(0), expected.ptr<uint8_t>(0) + 3 * 256 * 256, result.ptr<uint8_t>(0)));
+        }
+
+        SECTION("GIMP scale is the same as per pixel function, blue " + std::to_string(b)){
+            std::vector<float> expected(3 * 256 * 256);
+            for (int i = 0; i < 256 * 256; ++i){
+                cv::Vec3b color = m(i / 256, i % 256);
+                cvtColorBGRToHSVScaled<GIMPScale>(color[0], color[1], color[2], expected.data() + 3 * i);
+            }
+            cv::Mat result = cvtImgColorsToGIMPHSV(img);
+            REQUIRE(result.type() == CV_32FC3);
+            REQUIRE(std::equal(expected.begin(), expected.end(), result.ptr<float>(0)));
+        }
+    }
+}
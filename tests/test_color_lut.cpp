@@ -0,0 +1,66 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/color_lut.hpp"
+#include "../src/utils.hpp"
+
+// std
+#include<vector>
+#include<cstdlib>
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+
+TEST_CASE("Tests for ColorLUT", "[color_lut][ColorLUT]"){
+    SECTION("table of FILTER_GIMP is the same as picker for 8 bit and float channels"){
+        const ColorLUT& byteLUT = gimpFilterLUT();
+        ColorLUT floatLUT = compileColorLUT(FILTER_GIMP, LUTChannels::FLOAT_CHANNELS);
+
+        srand(37);
+        for (int i = 0; i < 200000; ++i){
+            uint8_t b = rand()%256, g = rand()%256, r = rand()%256;
+            std::vector<double> hsv = cvtColorBGRToHSV(b, g, r);
+            cv::Vec3f color(static_cast<float>(hsv[0]*HUE_SCALE_GIMP), static_cast<float>(hsv[1]*SATURATION_SCALE_GIMP),
+                    static_cast<float>(hsv[2]*VALUE_SCALE_GIMP));
+
+            REQUIRE(floatLUT.get(b, g, r) == FILTER_GIMP.isCorrectPixel(color[0], color[1], color[2]));
+            REQUIRE(byteLUT.get(b, g, r) == FILTER_GIMP.isCorrectPixel(cv::saturate_cast<uint8_t>(color[0]),
+                    cv::saturate_cast<uint8_t>(color[1]), cv::saturate_cast<uint8_t>(color[2])));
+        }
+        REQUIRE(byteLUT.count() > 0);
+    }
+
+    SECTION("set and get"){
+        ColorLUT lut;
+        REQUIRE(lut.count() == 0);
+        lut.set(1, 2, 3, true);
+        lut.set(255, 255, 255, true);
+        REQUIRE(lut.get(1, 2, 3));
+        REQUIRE(lut.get(255, 255, 255));
+        REQUIRE_FALSE(lut.get(3, 2, 1));
+        REQUIRE(lut.count() == 2);
+        lut.set(1, 2, 3, false);
+        REQUIRE(lut.count() == 1);
+    }
+
+    SECTION("pixels picked from BGR image are the same as from HSV image"){
+        cv::Mat img = cv::imread(std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0]);
+        cv::Mat hsv = cvtImgColorsToGIMPHSV(img);
+
+        REQUIRE(pickPixels(img, compileColorLUT(FILTER_GIMP, LUTChannels::FLOAT_CHANNELS)) == pickPixels(hsv, FILTER_GIMP));
+
+        auto expected = neighbourAwarePixelPicker(hsv, FILTER_GIMP, DEFUALT_PIX_CHOOSE_WIDTH, DEFUALT_PIX_CHOOSE_HEIGHT,
+                                                  DEFUALT_PIX_CHOOSE_PERCENT);
+        auto result = neighbourAwarePixelPicker(img, gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH, DEFUALT_PIX_CHOOSE_HEIGHT,
+                                                DEFUALT_PIX_CHOOSE_PERCENT);
+        REQUIRE(expected == result);
+    }
+
+    SECTION("wrong image type"){
+        cv::Mat img(10, 10, CV_32FC3);
+        REQUIRE_THROWS(pixelsMask(img, gimpFilterLUT()));
+        REQUIRE_THROWS(pickPixels(img, gimpFilterLUT()));
+    }
+}
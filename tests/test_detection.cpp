@@ -0,0 +1,170 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/detection.hpp"
+
+// std
+#include <vector>
+#include <string>
+#include <sstream>
+#include <limits>
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+
+TEST_CASE("Tests for detection functions", "[detection][detectSegments]"){
+    SECTION("detection of rectangle segment"){
+        PackedPixelsMap pixels(20, 30);
+        for (int i = 4; i < 9; ++i){
+            for (int j = 10; j < 17; ++j){
+                pixels.set(i, j, true);
+            }
+        }
+        auto stats = findSegmentStats(pixels);
+        REQUIRE(stats.size() == 1);
+
+        Detection d = makeDetection(stats[0], getHuMoments(stats[0]));
+        REQUIRE(d.bbox.x == 10);
+        REQUIRE(d.bbox.y == 4);
+        REQUIRE(d.bbox.width == 7);
+        REQUIRE(d.bbox.height == 5);
+        REQUIRE(d.area == 35);
+        REQUIRE(d.centroid.x == Approx(13.0));
+        REQUIRE(d.centroid.y == Approx(6.0));
+        for (size_t m = 0; m < HuMomentSet::SIZE; ++m){
+            REQUIRE(d.moments[m] == getHuMoments(stats[0])[m]);
+        }
+    }
+
+    SECTION("disk is accepted, too small segment is removed"){
+        PackedPixelsMap pixels(100, 120);
+        for (int i = 0; i < 100; ++i){
+            for (int j = 0; j < 120; ++j){
+                if ((i - 50) * (i - 50) + (j - 70) * (j - 70) <= 30 * 30){
+                    pixels.set(i, j, true);
+                }
+            }
+        }
+        pixels.set(2, 2, true);
+
+        auto detections = detectSegments(pixels, 10);
+        REQUIRE(detections.size() == 1);
+        REQUIRE(detections[0].bbox.x == 40);
+        REQUIRE(detections[0].bbox.y == 20);
+        REQUIRE(detections[0].bbox.width == 61);
+        REQUIRE(detections[0].bbox.height == 61);
+        REQUIRE(detections[0].centroid.x == Approx(70.0));
+        REQUIRE(detections[0].centroid.y == Approx(50.0));
+        REQUIRE(detections[0].area == pixels.count() - 1);
+    }
+
+    SECTION("the same segments and rects as size and moments filters for data images"){
+        for (auto& name : TEST_FILES_NAMES){
+            cv::Mat img = cv::imread(std::string(LEGO_DATA_DIR) + name);
+            PackedPixelsMap pixels = streamRankFilterPixelPicker(img, DEFUALT_RANK_FILTER_WIDTH, DEFUALT_RANK_FILTER_HEIGHT,
+                                                                 DEFAULT_RANK_FILTER_RANK, gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH,
+                                                                 DEFUALT_PIX_CHOOSE_HEIGHT, DEFUALT_PIX_CHOOSE_PERCENT);
+
+            cv::Mat expected = img.clone();
+            std::vector<SegmentStats> valid;
+            for (auto& seg : removeAdditionalSegments(100, findSegmentStats(pixels))){
+                if (isValidSegment(seg)){
+                    valid.emplace_back(seg);
+                    drawBoundingRectForSegment(expected, seg);
+                }
+            }
+
+            auto detections = detectLegoWheels(img, 100);
+            REQUIRE(detections.size() == valid.size());
+            for (size_t i = 0; i < valid.size(); ++i){
+                auto points = segmentBoundingRectPoints(valid[i]);
+                REQUIRE(detections[i].id == valid[i].id);
+                REQUIRE(detections[i].area == valid[i].count);
+                REQUIRE(detections[i].bbox.y == static_cast<int>(points[0]));
+                REQUIRE(detections[i].bbox.y + detections[i].bbox.height - 1 == static_cast<int>(points[1]));
+                REQUIRE(detections[i].bbox.x == static_cast<int>(points[2]));
+                REQUIRE(detections[i].bbox.x + detections[i].bbox.width - 1 == static_cast<int>(points[3]));
+            }
+
+            drawDetections(img, detections);
+            int different = 0;
+            for (int i = 0; i < img.rows; ++i){
+                for (int j = 0; j < img.cols; ++j){
+                    different += img.at<cv::Vec3b>(i, j) != expected.at<cv::Vec3b>(i, j);
+                }
+            }
+            REQUIRE(different == 0);
+        }
+    }
+}
+
+TEST_CASE("Tests for DetectionWriter class", "[detection][DetectionWriter]"){
+    Detection d;
+    d.id = 3;
+    d.bbox = cv::Rect(1, 2, 3, 4);
+    d.area = 5;
+    d.centroid = cv::Point2d(1.5, 2.25);
+    for (size_t m = 0; m < HuMomentSet::SIZE; ++m){
+        d.moments[m] = static_cast<double>(m) / 4.0;
+    }
+
+    SECTION("JSON Lines"){
+        std::ostringstream out;
+        DetectionWriter writer(out, DetectionFormat::JSON_LINES);
+        writer.write("dir/a\"b.jpg", {d});
+        d.moments[HuMomentSet::M10] = std::numeric_limits<double>::quiet_NaN();
+        writer.write("c.jpg", {});
+        writer.write("d.jpg", {d, d});
+
+        std::istringstream in(out.str());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)){
+            lines.emplace_back(line);
+        }
+
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[0] == "{\"image\":\"dir/a\\\"b.jpg\",\"detections\":[{\"id\":3,"
+                            "\"bbox\":{\"x\":1,\"y\":2,\"width\":3,\"height\":4},\"area\":5,"
+                            "\"centroid\":{\"x\":1.5,\"y\":2.25},\"moments\":{\"M1\":0,\"M2\":0.25,\"M3\":0.5,"
+                            "\"M4\":0.75,\"M5\":1,\"M6\":1.25,\"M7\":1.5,\"M8\":1.75,\"M9\":2,\"M10\":2.25}}]}");
+        REQUIRE(lines[1] == "{\"image\":\"c.jpg\",\"detections\":[]}");
+        REQUIRE(lines[2].find("\"M10\":null}") != std::string::npos);
+    }
+
+    SECTION("CSV"){
+        std::ostringstream out;
+        DetectionWriter writer(out, DetectionFormat::CSV);
+        writer.write("a.jpg", {d});
+        writer.write("b.jpg", {});
+        writer.write("c.jpg", {d, d});
+
+        std::istringstream in(out.str());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)){
+            lines.emplace_back(line);
+        }
+
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[0] == "image;id;x;y;width;height;area;centroid_x;centroid_y;M1;M2;M3;M4;M5;M6;M7;M8;M9;M10");
+        REQUIRE(lines[1] == "a.jpg;3;1;2;3;4;5;1.5;2.25;0;0.25;0.5;0.75;1;1.25;1.5;1.75;2;2.25");
+        REQUIRE(lines[2] == "c.jpg;3;1;2;3;4;5;1.5;2.25;0;0.25;0.5;0.75;1;1.25;1.5;1.75;2;2.25");
+    }
+
+    SECTION("CSV quoting of image names"){
+        std::ostringstream out;
+        DetectionWriter writer(out, DetectionFormat::CSV);
+        writer.write("a;b.jpg", {d});
+        writer.write("say \"lego\".jpg", {d});
+        writer.write("line\nbreak.jpg", {d});
+
+        std::string values = ";3;1;2;3;4;5;1.5;2.25;0;0.25;0.5;0.75;1;1.25;1.5;1.75;2;2.25\n";
+        REQUIRE(out.str() == "image;id;x;y;width;height;area;centroid_x;centroid_y;M1;M2;M3;M4;M5;M6;M7;M8;M9;M10\n"
+                             "\"a;b.jpg\"" + values +
+                             "\"say \"\"lego\"\".jpg\"" + values +
+                             "\"line\nbreak.jpg\"" + values);
+    }
+}
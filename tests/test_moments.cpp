@@ -0,0 +1,84 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/moments.hpp"
+
+// std
+#include<vector>
+#include<fstream>
+#include<string>
+#include<cstdio>
+
+
+/**
+ * @brief shapeMap Create map with filled disk or rectangle in the middle.
+ */
+PackedPixelsMap shapeMap(bool disk, int height, int width){
+    PackedPixelsMap map(120, 160);
+    for (int row = 0; row < map.rows(); ++row){
+        for (int col = 0; col < map.cols(); ++col){
+            int y = row - map.rows() / 2, x = col - map.cols() / 2;
+            bool inside = disk ? x * x + y * y <= height * height : std::abs(y) < height && std::abs(x) < width;
+            map.set(row, col, inside);
+        }
+    }
+    return map;
+}
+
+TEST_CASE("Tests for HuMomentSet", "[moments][HuMomentSet]"){
+    SECTION("set is the same as map view"){
+        auto segments = findRunSegments(shapeMap(false, 7, 31));
+        REQUIRE(segments.size() == 1);
+
+        HuMomentSet set = getHuMoments(segments[0]);
+        Moments map = getMoments(segments[0]);
+        REQUIRE(map.size() == HuMomentSet::SIZE);
+        REQUIRE(map["M1"] == set[HuMomentSet::M1]);
+        REQUIRE(map["M7"] == set[HuMomentSet::M7]);
+        REQUIRE(map["M10"] == set[HuMomentSet::M10]);
+
+        HuMomentSet back = fromMomentsMap(map);
+        REQUIRE(back.values == set.values);
+    }
+
+    SECTION("set is the same for all segment representations"){
+        auto map = shapeMap(true, 25, 0);
+        HuMomentSet fromPixels = getHuMoments(findSegments(map)[0]);
+        HuMomentSet fromRuns = getHuMoments(findRunSegments(map)[0]);
+        HuMomentSet fromStats = getHuMoments(findSegmentStats(map)[0]);
+
+        for (size_t i = 0; i < HuMomentSet::SIZE; ++i){
+            REQUIRE(fromRuns[i] == Approx(fromPixels[i]).epsilon(1e-9).margin(1e-12));
+            REQUIRE(fromStats[i] == Approx(fromPixels[i]).epsilon(1e-9).margin(1e-12));
+        }
+    }
+
+    SECTION("disk is valid, long rectangle is not"){
+        auto disk = findSegmentStats(shapeMap(true, 25, 0));
+        auto rectangle = findSegmentStats(shapeMap(false, 5, 50));
+        REQUIRE(isValidSegment(disk[0]));
+        REQUIRE_FALSE(isValidSegment(rectangle[0]));
+        REQUIRE(isValidMoments(getHuMoments(disk[0])) == isValidSegment(findRunSegments(shapeMap(true, 25, 0))[0]));
+    }
+
+    SECTION("moments saved to csv"){
+        std::string csvName = "test_moments.csv";
+        HuMomentSet set;
+        for (size_t i = 0; i < HuMomentSet::SIZE; ++i){
+            set[i] = static_cast<double>(i) + 0.5;
+        }
+        saveMomentsToCSV(std::vector<HuMomentSet>({set, set}), csvName);
+
+        std::ifstream file(csvName);
+        std::string line;
+        int lines = 0;
+        while (std::getline(file, line)){
+            REQUIRE(line == "0.5;1.5;2.5;3.5;4.5;5.5;6.5;7.5;8.5;9.5");
+            ++lines;
+        }
+        REQUIRE(lines == 2);
+        file.close();
+        std::remove(csvName.c_str());
+    }
+}
@@ -0,0 +1,142 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/morphology.hpp"
+#include "../src/utils.hpp"
+
+// std
+#include <vector>
+#include <cstdlib>
+
+
+/**
+ * @brief randomPixelsMap Map with given percent of chosen pixels, in blocks of random size
+ * so windows are neither all empty nor all full.
+ */
+PackedPixelsMap randomPixelsMap(int rows, int cols, int percent){
+    PackedPixelsMap pixels(rows, cols);
+    for (int i = 0; i < rows; ++i){
+        for (int j = 0; j < cols; ++j){
+            if (rand() % 100 < percent){
+                int h = 1 + rand() % 4, w = 1 + rand() % 6;
+                for (int r = i; r < std::min(rows, i + h); ++r){
+                    for (int c = j; c < std::min(cols, j + w); ++c){
+                        pixels.set(r, c, true);
+                    }
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+TEST_CASE("Tests for morphology functions", "[morphology]"){
+    SECTION("dilation and erosion are the same as scalar closing and opening"){
+        srand(21);
+        ThreadsNumberGuard guard(2);
+        for (auto size : std::vector<std::vector<int>>({{1, 1}, {7, 5}, {50, 130}, {67, 200}, {3, 64}, {40, 129}})){
+            for (int percent : {2, 20, 60}){
+                PackedPixelsMap pixels = randomPixelsMap(size[0], size[1], percent);
+                for (auto window : std::vector<std::vector<int>>({{1, 1}, {3, 3}, {5, 1}, {1, 7}, {31, 31}, {65, 3}, {129, 5}, {9, 51}})){
+                    REQUIRE(dilation(pixels, window[0], window[1]) == closing(pixels, window[0], window[1]));
+                    REQUIRE(erosion(pixels, window[0], window[1]) == opening(pixels, window[0], window[1]));
+                }
+            }
+        }
+    }
+
+    SECTION("opening and closing are composed from scalar operations"){
+        srand(22);
+        PackedPixelsMap pixels = randomPixelsMap(90, 150, 15);
+        for (int size : {3, 5, 11}){
+            REQUIRE(morphologicalOpening(pixels, size, size) == closing(opening(pixels, size, size), size, size));
+            REQUIRE(morphologicalClosing(pixels, size, size) == opening(closing(pixels, size, size), size, size));
+        }
+    }
+
+    SECTION("opening removes small segments, closing fills small holes"){
+        PackedPixelsMap pixels(40, 40);
+        for (int i = 5; i < 25; ++i){
+            for (int j = 5; j < 25; ++j){
+                pixels.set(i, j, true);
+            }
+        }
+        pixels.set(15, 15, false);
+        pixels.set(32, 32, true);
+
+        PackedPixelsMap opened = morphologicalOpening(pixels, 3, 3);
+        REQUIRE_FALSE(opened.get(32, 32));
+        REQUIRE(opened.get(6, 6));
+
+        PackedPixelsMap closed = morphologicalClosing(pixels, 3, 3);
+        REQUIRE(closed.get(15, 15));
+        REQUIRE(closed.get(32, 32));
+        REQUIRE_FALSE(closed.get(28, 28));
+    }
+
+    SECTION("byte masks are the same as pixels maps"){
+        srand(23);
+        ThreadsNumberGuard guard(3);
+        for (auto size : std::vector<std::vector<int>>({{7, 5}, {61, 97}, {130, 70}})){
+            PackedPixelsMap pixels = randomPixelsMap(size[0], size[1], 10);
+            cv::Mat mask(size[0], size[1], CV_8UC1);
+            for (int i = 0; i < size[0]; ++i){
+                for (int j = 0; j < size[1]; ++j){
+                    mask.at<uint8_t>(i, j) = pixels.get(i, j) ? 1 : 0;
+                }
+            }
+
+            for (auto window : std::vector<std::vector<int>>({{1, 1}, {3, 3}, {7, 1}, {1, 9}, {5, 21}, {33, 33}})){
+                cv::Mat dilated = dilateMask(mask, window[0], window[1]);
+                cv::Mat eroded = erodeMask(mask, window[0], window[1]);
+                PackedPixelsMap expectedDilated = closing(pixels, window[0], window[1]);
+                PackedPixelsMap expectedEroded = opening(pixels, window[0], window[1]);
+
+                int differences = 0;
+                for (int i = 0; i < size[0]; ++i){
+                    for (int j = 0; j < size[1]; ++j){
+                        differences += (dilated.at<uint8_t>(i, j) == 1) != expectedDilated.get(i, j);
+                        differences += (eroded.at<uint8_t>(i, j) == 1) != expectedEroded.get(i, j);
+                    }
+                }
+                REQUIRE(differences == 0);
+            }
+        }
+    }
+
+    SECTION("byte masks are max and min filters"){
+        cv::Mat mask(5, 7, CV_8UC1);
+        for (int i = 0; i < 5; ++i){
+            for (int j = 0; j < 7; ++j){
+                mask.at<uint8_t>(i, j) = static_cast<uint8_t>(i * 7 + j);
+            }
+        }
+        cv::Mat dilated = dilateMask(mask, 3, 3);
+        cv::Mat eroded = erodeMask(mask, 3, 3);
+        REQUIRE(dilated.at<uint8_t>(2, 3) == 25);
+        REQUIRE(eroded.at<uint8_t>(2, 3) == 9);
+        REQUIRE(dilated.at<uint8_t>(0, 0) == 0);
+        REQUIRE(eroded.at<uint8_t>(4, 6) == 34);
+
+        REQUIRE_THROWS(dilateMask(cv::Mat(5, 5, CV_8UC3), 3, 3));
+    }
+
+    SECTION("cleanup of pixels map"){
+        srand(24);
+        PackedPixelsMap pixels = randomPixelsMap(80, 120, 10);
+        REQUIRE(cleanupMask(pixels, MaskCleanup()) == pixels);
+
+        MaskCleanup cleanup;
+        cleanup.openingSize = 3;
+        cleanup.closingSize = 5;
+        REQUIRE(cleanup.enabled());
+        REQUIRE(cleanupMask(pixels, cleanup) == morphologicalClosing(morphologicalOpening(pixels, 3, 3), 5, 5));
+    }
+
+    SECTION("wrong window"){
+        PackedPixelsMap pixels(10, 10);
+        REQUIRE_THROWS(dilation(pixels, 2, 3));
+        REQUIRE_THROWS(erosion(pixels, 3, -1));
+    }
+}
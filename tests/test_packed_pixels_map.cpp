@@ -0,0 +1,93 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/packed_pixels_map.hpp"
+
+// std
+#include<vector>
+#include<cstdint>
+#include<utility>
+#include<type_traits>
+
+
+TEST_CASE("Tests for PackedPixelsMap class", "[packed_pixels_map]"){
+    SECTION("rows are aligned and padding bits are zero"){
+        PackedPixelsMap map(5, 130);
+        REQUIRE(map.rows() == 5);
+        REQUIRE(map.cols() == 130);
+        REQUIRE(map.wordsInRow() == 3);
+        REQUIRE(map.stride() % (PackedPixelsMap::ALIGNMENT / sizeof(uint64_t)) == 0);
+
+        for (int i = 0; i < map.rows(); ++i){
+            REQUIRE(reinterpret_cast<uintptr_t>(map.row(i)) % PackedPixelsMap::ALIGNMENT == 0);
+            for (int j = 0; j < map.cols(); ++j){
+                map.set(i, j, true);
+            }
+            REQUIRE(map.row(i)[2] == 3u);
+        }
+        REQUIRE(map.count() == 5 * 130);
+    }
+
+    SECTION("set and get single pixels"){
+        PackedPixelsMap map(3, 70);
+        map.set(0, 0, true);
+        map.set(1, 63, true);
+        map.set(2, 64, true);
+        map.set(2, 69, true);
+        map.set(2, 69, false);
+
+        REQUIRE(map.get(0, 0));
+        REQUIRE(map.get(1, 63));
+        REQUIRE(map.get(2, 64));
+        REQUIRE(!map.get(2, 69));
+        REQUIRE(!map.get(0, 1));
+        REQUIRE(map[1][63]);
+        REQUIRE(map.count() == 3);
+    }
+
+    SECTION("conversion from and to legacy PixelsMap"){
+        PixelsMap legacy = {
+            {true, false, false, true},
+            {false, false, true, false},
+            {true, true, true, true}
+        };
+
+        PackedPixelsMap map = legacy;
+        REQUIRE(map.rows() == 3);
+        REQUIRE(map.cols() == 4);
+        for (size_t i = 0; i < legacy.size(); ++i){
+            for (size_t j = 0; j < legacy[i].size(); ++j){
+                REQUIRE(map[i][j] == legacy[i][j]);
+            }
+        }
+
+        PixelsMap back = map;
+        REQUIRE(back == legacy);
+
+        PackedPixelsMap copy = map;
+        REQUIRE(copy == map);
+        copy.set(0, 1, true);
+        REQUIRE(copy != map);
+    }
+
+    SECTION("move leaves empty map"){
+        REQUIRE(std::is_nothrow_move_constructible<PackedPixelsMap>::value);
+        REQUIRE(std::is_nothrow_move_assignable<PackedPixelsMap>::value);
+        REQUIRE(std::is_nothrow_default_constructible<PackedPixelsMap>::value);
+        REQUIRE(PackedPixelsMap() == PackedPixelsMap(0, 0));
+
+        PackedPixelsMap map(3, 70);
+        map.set(2, 64, true);
+        PackedPixelsMap moved = std::move(map);
+        REQUIRE(moved.get(2, 64));
+        REQUIRE(map.empty());
+        REQUIRE(map.count() == 0);
+
+        map = moved;
+        REQUIRE(map == moved);
+        moved = std::move(map);
+        REQUIRE(map.empty());
+        REQUIRE(moved.count() == 1);
+    }
+}
@@ -0,0 +1,69 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/pipeline.hpp"
+
+// std
+#include<vector>
+#include<string>
+#include<cstdlib>
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+
+TEST_CASE("Tests for streamRankFilterPixelPicker function", "[pipeline][streamRankFilterPixelPicker]"){
+    SECTION("the same pixels as staged pipeline for data images"){
+        for (unsigned int threads : {1u, 3u}){
+            ThreadsNumberGuard guard(threads);
+            for (auto& name : TEST_FILES_NAMES){
+                cv::Mat img = cv::imread(std::string(LEGO_DATA_DIR) + name);
+
+                auto expected = neighbourAwarePixelPicker(rankFilter(img, DEFUALT_RANK_FILTER_WIDTH, DEFUALT_RANK_FILTER_HEIGHT,
+                                                                     DEFAULT_RANK_FILTER_RANK),
+                                                          gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH, DEFUALT_PIX_CHOOSE_HEIGHT,
+                                                          DEFUALT_PIX_CHOOSE_PERCENT);
+                auto result = streamRankFilterPixelPicker(img, DEFUALT_RANK_FILTER_WIDTH, DEFUALT_RANK_FILTER_HEIGHT,
+                                                          DEFAULT_RANK_FILTER_RANK, gimpFilterLUT(), DEFUALT_PIX_CHOOSE_WIDTH,
+                                                          DEFUALT_PIX_CHOOSE_HEIGHT, DEFUALT_PIX_CHOOSE_PERCENT);
+                REQUIRE(expected == result);
+            }
+        }
+    }
+
+    SECTION("the same pixels as staged pipeline for random images and windows"){
+        // lookup table that chooses about half of colors
+        ColorLUT lut;
+        srand(53);
+        for (int i = 0; i < 1 << 16; ++i){
+            for (int k = 0; k < 128; ++k){
+                lut.set(static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i), static_cast<uint8_t>(rand()%256), true);
+            }
+        }
+
+        ThreadsNumberGuard guard(2);
+        for (int size : {3, 5, 7, 9}){
+            for (auto window : std::vector<std::vector<int>>({{1, 1}, {3, 5}, {7, 3}, {11, 11}})){
+                cv::Mat img(37 + size, 71, CV_8UC3);
+                for (int i = 0; i < img.rows; ++i){
+                    for (int j = 0; j < img.cols; ++j){
+                        img.at<cv::Vec3b>(i, j) = cv::Vec3b(rand()%256, rand()%256, rand()%256);
+                    }
+                }
+                unsigned int rank = static_cast<unsigned int>(rand()%(size * size));
+
+                auto expected = neighbourAwarePixelPicker(rankFilter(img, size, size, rank), lut, window[0], window[1], 0.4f);
+                auto result = streamRankFilterPixelPicker(img, size, size, rank, lut, window[0], window[1], 0.4f);
+                REQUIRE(expected == result);
+            }
+        }
+    }
+
+    SECTION("wrong arguments"){
+        cv::Mat img(20, 20, CV_8UC3, cv::Scalar(0, 0, 0));
+        REQUIRE_THROWS(streamRankFilterPixelPicker(img, 5, 5, 25, gimpFilterLUT(), 3, 3, 0.5f));
+        REQUIRE_THROWS(streamRankFilterPixelPicker(img, 5, 5, 5, gimpFilterLUT(), 4, 3, 0.5f));
+        REQUIRE_THROWS(streamRankFilterPixelPicker(cv::Mat(20, 20, CV_32FC3), 5, 5, 5, gimpFilterLUT(), 3, 3, 0.5f));
+    }
+}
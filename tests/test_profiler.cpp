@@ -0,0 +1,126 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/profiler.hpp"
+#include "../src/detection.hpp"
+
+// std
+#include <string>
+#include <sstream>
+#include <thread>
+
+// opencv
+#include <opencv2/opencv.hpp>
+
+
+TEST_CASE("Tests for ProfileReport class", "[profiler][ProfileReport]"){
+    SECTION("stages, counters and memory"){
+        ProfileReport report;
+        report.addStage("a", 0.5, 1000000);
+        report.addStage("a", 0.5, 1000000);
+        report.addCounter("segments", 3);
+        report.allocate(100);
+        report.allocate(50);
+        report.release(100);
+        report.allocate(20);
+
+        REQUIRE(report.stages["a"].calls == 2);
+        REQUIRE(report.stages["a"].pixels == 2000000);
+        REQUIRE(report.stages["a"].megapixelsPerSecond() == Approx(2.0));
+        REQUIRE(report.counters["segments"] == 3);
+        REQUIRE(report.currentBytes == 70);
+        REQUIRE(report.peakBytes == 150);
+
+        ProfileReport other;
+        other.addStage("a", 1.0, 0);
+        other.addStage("b", 1.0, 0);
+        other.addCounter("segments", 2);
+        other.allocate(400);
+        report.merge(other);
+
+        REQUIRE(report.stages["a"].calls == 3);
+        REQUIRE(report.stages["a"].seconds == Approx(2.0));
+        REQUIRE(report.stages["b"].calls == 1);
+        REQUIRE(report.stages["b"].megapixelsPerSecond() == 0.0);
+        REQUIRE(report.counters["segments"] == 5);
+        REQUIRE(report.peakBytes == 400);
+    }
+
+    SECTION("JSON report"){
+        ProfileReport report;
+        report.images = 1;
+        report.addStage("a", 0.5, 1000000);
+        report.addCounter("segments", 3);
+        report.allocate(64);
+
+        std::ostringstream out;
+        report.writeJSON(out, "dir/\"x\".jpg");
+        REQUIRE(out.str() == "{\"name\":\"dir/\\\"x\\\".jpg\",\"images\":1,\"peak_bytes\":64,\"stages\":{\"a\":{\"calls\":1,"
+                             "\"seconds\":0.5,\"pixels\":1000000,\"megapixels_per_second\":2}},\"counters\":{\"segments\":3}}\n");
+    }
+
+    SECTION("JSON escaping of control characters"){
+        ProfileReport report;
+        std::ostringstream out;
+        report.writeJSON(out, "a\nb\tc\\d\x01.jpg");
+        REQUIRE(out.str() == "{\"name\":\"a\\nb\\tc\\\\d\\u0001.jpg\",\"images\":0,\"peak_bytes\":0,"
+                             "\"stages\":{},\"counters\":{}}\n");
+        REQUIRE(jsonString("\r\"") == "\"\\r\\\"\"");
+    }
+}
+
+TEST_CASE("Tests for profiling scopes", "[profiler][ProfileSession]"){
+    SECTION("scopes use report of current thread only"){
+        ProfileReport report;
+        {
+            ProfileSession session(report);
+            ScopedStageTimer timer("stage", 10);
+            ScopedAllocation allocation(256);
+            profileCount("counter", 2);
+
+            // other thread has no session
+            std::thread other([](){
+                ScopedStageTimer otherTimer("other", 1);
+                profileCount("counter", 100);
+            });
+            other.join();
+        }
+
+        REQUIRE(currentProfileReport() == nullptr);
+        REQUIRE(report.images == 1);
+        REQUIRE(report.stages.size() == 1);
+        REQUIRE(report.stages["stage"].calls == 1);
+        REQUIRE(report.stages["stage"].pixels == 10);
+        REQUIRE(report.counters["counter"] == 2);
+        REQUIRE(report.peakBytes == 256);
+        REQUIRE(report.currentBytes == 0);
+    }
+
+    SECTION("stages of detection"){
+        cv::Mat img = cv::imread(std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0]);
+        gimpFilterLUT();
+
+        ProfileReport report;
+        {
+            ProfileSession session(report);
+            drawDetections(img, detectLegoWheels(img, 100));
+        }
+
+#ifdef LEGO_PROFILING
+        REQUIRE(report.stages["rank_filter_pixel_picker"].calls == 1);
+        REQUIRE(report.stages["rank_filter_pixel_picker"].pixels == img.total());
+        REQUIRE(report.stages["find_segments"].calls == 1);
+        REQUIRE(report.stages["remove_segments"].calls == 1);
+        REQUIRE(report.stages["moments"].calls == 1);
+        REQUIRE(report.stages["drawing"].calls == 1);
+        REQUIRE(report.counters.count("segments") == 1);
+        REQUIRE(report.peakBytes > 0);
+#else
+        // stages are not measured without LEGO_PROFILING
+        REQUIRE(report.stages.empty());
+        REQUIRE(report.counters.empty());
+        REQUIRE(report.peakBytes == 0);
+#endif
+    }
+}
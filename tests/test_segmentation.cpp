@@ -0,0 +1,392 @@
+// catch2
+#include "catch2.hpp"
+
+// lego
+#include "../src/segmentation.hpp"
+#include "../src/moments.hpp"
+
+// std
+#include<vector>
+#include<set>
+#include<cstdlib>
+
+
+/**
+ * @brief segmentsAsSets Convert segments to comparable form - pixels of each segment as set.
+ */
+std::vector<std::set<PixelPos>> segmentsAsSets(const std::vector<Segment>& segments){
+    std::vector<std::set<PixelPos>> result;
+    for (auto& seg : segments){
+        result.emplace_back(seg.pixels.begin(), seg.pixels.end());
+    }
+    return result;
+}
+
+/**
+ * @brief randomPixelsMap Map with each pixel chosen with probability density / 10.
+ */
+static PackedPixelsMap randomPixelsMap(int rows, int cols, int density){
+    PackedPixelsMap map(rows, cols);
+    for (int row = 0; row < map.rows(); ++row){
+        for (int col = 0; col < map.cols(); ++col){
+            map.set(row, col, rand()%10 < density);
+        }
+    }
+    return map;
+}
+
+TEST_CASE("Tests for findSegments function", "[segmentation][findSegments]"){
+    SECTION("simple shapes"){
+        PixelsMap legacy = {
+            {true,  true,  false, false, true},
+            {false, true,  false, true,  true},
+            {true,  false, false, false, false},
+            {true,  false, true,  false, true},
+            {true,  true,  true,  false, true}
+        };
+
+        auto segments = findSegments(legacy);
+        REQUIRE(segments.size() == 4);
+        REQUIRE(segments[0].id == 1);
+        REQUIRE(segments[0].pixels.size() == 3);
+        REQUIRE(segments[1].pixels.size() == 3);
+        REQUIRE(segments[2].pixels.size() == 6);
+        REQUIRE(segments[3].pixels.size() == 2);
+        // diagonal pixels are not connected
+        REQUIRE(segments[0].pixels.front() == PixelPos(0, 0));
+    }
+
+    SECTION("U shapes that are merged in later rows"){
+        PackedPixelsMap map(4, 70);
+        for (int row = 0; row < 4; ++row){
+            map.set(row, 0, true);
+            map.set(row, 65, true);
+            map.set(row, 69, true);
+        }
+        for (int col = 0; col < 70; ++col){
+            map.set(3, col, true);
+        }
+
+        auto segments = findSegments(map);
+        REQUIRE(segments.size() == 1);
+        REQUIRE(segments[0].pixels.size() == 79);
+    }
+
+    SECTION("same segments as flood fill for random maps"){
+        srand(23);
+
+        for (int density = 1; density < 10; density += 2){
+            PackedPixelsMap map = randomPixelsMap(57, 131, density);
+
+            auto expected = findSegmentsFloodFill(map);
+            auto result = findSegments(map);
+
+            REQUIRE(expected.size() == result.size());
+            for (size_t i = 0; i < expected.size(); ++i){
+                REQUIRE(expected[i].id == result[i].id);
+            }
+            REQUIRE(segmentsAsSets(expected) == segmentsAsSets(result));
+        }
+    }
+
+    SECTION("empty map"){
+        REQUIRE(findSegments(PackedPixelsMap(0, 0)).empty());
+        REQUIRE(findSegments(PackedPixelsMap(10, 10)).empty());
+    }
+}
+
+TEST_CASE("Tests for findRunSegments function", "[segmentation][findRunSegments]"){
+    SECTION("runs that cross words"){
+        PackedPixelsMap map(3, 200);
+        for (int col = 10; col < 150; ++col){
+            map.set(0, col, true);
+        }
+        map.set(1, 63, true);
+        map.set(1, 64, true);
+        map.set(1, 199, true);
+        map.set(2, 128, true);
+
+        auto segments = findRunSegments(map);
+        REQUIRE(segments.size() == 3);
+        REQUIRE(segments[0].runs.size() == 2);
+        REQUIRE(segments[0].runs[0].colStart == 10);
+        REQUIRE(segments[0].runs[0].colEnd == 150);
+        REQUIRE(segments[0].size() == 142);
+        REQUIRE(segments[1].runs[0].colStart == 199);
+        REQUIRE(segments[1].runs[0].colEnd == 200);
+        REQUIRE(segments[2].size() == 1);
+    }
+
+    SECTION("same segments, moments and bounding points as findSegments for random maps"){
+        srand(29);
+
+        for (int density = 1; density < 10; density += 2){
+            PackedPixelsMap map = randomPixelsMap(61, 197, density);
+
+            auto expected = findSegments(map);
+            auto result = findRunSegments(map);
+
+            REQUIRE(expected.size() == result.size());
+            std::vector<Segment> converted;
+            for (size_t i = 0; i < expected.size(); ++i){
+                REQUIRE(expected[i].id == result[i].id);
+                REQUIRE(expected[i].pixels.size() == result[i].size());
+                REQUIRE(segmentBoundingRectPoints(expected[i]) == segmentBoundingRectPoints(result[i]));
+
+                Moments expectedMoments = getMoments(expected[i]);
+                Moments resultMoments = getMoments(result[i]);
+                for (auto& moment : expectedMoments){
+                    REQUIRE(resultMoments[moment.first] == Approx(moment.second).epsilon(1e-9).margin(1e-12));
+                }
+
+                converted.emplace_back(runSegmentToSegment(result[i]));
+            }
+            REQUIRE(segmentsAsSets(expected) == segmentsAsSets(converted));
+        }
+    }
+
+    SECTION("run length segments are removed by size"){
+        PixelsMap legacy = {
+            {true,  true,  false, false, true},
+            {false, true,  false, true,  true},
+            {true,  false, false, false, false}
+        };
+
+        auto segments = removeAdditionalSegments(2, findRunSegments(legacy));
+        REQUIRE(segments.size() == 2);
+        REQUIRE(segments[0].id == 1);
+        REQUIRE(segments[1].id == 2);
+    }
+}
+
+TEST_CASE("Tests for findSegmentStats function", "[segmentation][findSegmentStats]"){
+    SECTION("same size, bounding points and moments as run length segments for random maps"){
+        srand(31);
+
+        for (int density = 1; density < 10; density += 2){
+            PackedPixelsMap map = randomPixelsMap(67, 149, density);
+
+            auto expected = findRunSegments(map);
+            auto result = findSegmentStats(map);
+
+            REQUIRE(expected.size() == result.size());
+            for (size_t i = 0; i < expected.size(); ++i){
+                REQUIRE(expected[i].id == result[i].id);
+                REQUIRE(expected[i].size() == result[i].count);
+                REQUIRE(segmentBoundingRectPoints(expected[i]) == segmentBoundingRectPoints(result[i]));
+
+                Moments expectedMoments = getMoments(expected[i]);
+                Moments resultMoments = getMoments(result[i]);
+                for (auto& moment : expectedMoments){
+                    REQUIRE(resultMoments[moment.first] == Approx(moment.second).epsilon(1e-9).margin(1e-12));
+                }
+                REQUIRE(isValidSegment(expected[i]) == isValidSegment(result[i]));
+            }
+        }
+    }
+
+    SECTION("statistics of U shape are merged"){
+        PackedPixelsMap map(3, 5);
+        for (int row = 0; row < 3; ++row){
+            map.set(row, 0, true);
+            map.set(row, 4, true);
+        }
+        for (int col = 0; col < 5; ++col){
+            map.set(2, col, true);
+        }
+
+        auto stats = findSegmentStats(map);
+        REQUIRE(stats.size() == 1);
+        REQUIRE(stats[0].count == 9);
+        REQUIRE(segmentBoundingRectPoints(stats[0]) == std::vector<unsigned int>({0, 2, 0, 4}));
+        REQUIRE(stats[0].moments.m00 == 9.0);
+        REQUIRE(stats[0].moments.m10 == 18.0);
+        REQUIRE(stats[0].moments.m01 == 12.0);
+        REQUIRE(removeAdditionalSegments(9, stats).empty());
+    }
+}
+
+/**
+ * @brief requireSameStats Check that statistics are equal, moments are sums of integers, so they are exact.
+ */
+void requireSameStats(const std::vector<SegmentStats>& expected, const std::vector<SegmentStats>& result){
+    REQUIRE(expected.size() == result.size());
+    int differences = 0;
+    for (size_t i = 0; i < expected.size(); ++i){
+        differences += expected[i].id != result[i].id || expected[i].count != result[i].count;
+        differences += segmentBoundingRectPoints(expected[i]) != segmentBoundingRectPoints(result[i]);
+        differences += expected[i].moments.m00 != result[i].moments.m00 || expected[i].moments.m11 != result[i].moments.m11;
+        differences += expected[i].moments.m21 != result[i].moments.m21 || expected[i].moments.m03 != result[i].moments.m03;
+    }
+    REQUIRE(differences == 0);
+}
+
+TEST_CASE("Tests for parallel labelling", "[segmentation][labelComponentsParallel]"){
+    SECTION("same labels and statistics as sequential labelling for random maps"){
+        srand(41);
+
+        for (unsigned int threads : {2, 3, 5}){
+            ThreadsNumberGuard guard(threads);
+            for (int density = 1; density < 10; density += 2){
+                PackedPixelsMap map = randomPixelsMap(203, 131, density);
+
+                LabelImage expected = labelComponents(map);
+                LabelImage result = labelComponentsParallel(map);
+                REQUIRE(expected.count == result.count);
+                REQUIRE(expected.labels == result.labels);
+
+                requireSameStats(labelStats(map), labelStatsParallel(map));
+                REQUIRE(segmentsAsSets(findSegments(map)) == segmentsAsSets(findSegmentsFloodFill(map)));
+            }
+        }
+    }
+
+    SECTION("comb that is merged only in last row of last strip"){
+        ThreadsNumberGuard guard(4);
+        PackedPixelsMap map(160, 40);
+        for (int row = 0; row < map.rows(); ++row){
+            for (int col = 0; col < map.cols(); col += 2){
+                map.set(row, col, true);
+            }
+        }
+        for (int col = 0; col < map.cols(); ++col){
+            map.set(map.rows() - 1, col, true);
+        }
+
+        LabelImage result = labelComponentsParallel(map);
+        REQUIRE(result.count == 1);
+        REQUIRE(result.labels == labelComponents(map).labels);
+        requireSameStats(labelStats(map), labelStatsParallel(map));
+        REQUIRE(findSegmentStats(map).size() == 1);
+    }
+
+    SECTION("empty and thin maps"){
+        ThreadsNumberGuard guard(3);
+        REQUIRE(labelComponentsParallel(PackedPixelsMap(0, 0)).count == 0);
+        REQUIRE(labelStatsParallel(PackedPixelsMap(10, 10)).empty());
+        REQUIRE(findSegmentsParallel(PackedPixelsMap(5, 70)).empty());
+    }
+}
+
+TEST_CASE("Tests for block labelling", "[segmentation][labelComponentsBlocks]"){
+    SECTION("same labels as pixels labelling for random maps"){
+        srand(43);
+
+        for (auto size : std::vector<std::pair<int, int>>({{1, 1}, {1, 70}, {2, 3}, {57, 131}, {64, 128}, {101, 65}})){
+            for (int density = 1; density < 10; density += 2){
+                PackedPixelsMap map = randomPixelsMap(size.first, size.second, density);
+
+                LabelImage expected = labelComponents(map);
+                LabelImage result = labelComponentsBlocks(map);
+                REQUIRE(expected.count == result.count);
+                REQUIRE(expected.labels == result.labels);
+            }
+        }
+    }
+
+    SECTION("diagonal pixels of pair of rows are not connected"){
+        PixelsMap legacy = {
+            {true,  false, true,  false},
+            {false, true,  false, true},
+            {true,  true,  false, false}
+        };
+
+        LabelImage result = labelComponentsBlocks(legacy);
+        REQUIRE(result.count == 4);
+        // block of second column is labelled before third column, but numbers follow first pixels
+        REQUIRE(result.labels == std::vector<uint32_t>({1, 0, 2, 0,
+                                                        0, 3, 0, 4,
+                                                        3, 3, 0, 0}));
+    }
+
+    SECTION("all algorithms give the same segments"){
+        srand(44);
+        PackedPixelsMap map = randomPixelsMap(77, 150, 6);
+
+        auto expected = findSegments(map, LabellingAlgorithm::FLOOD_FILL);
+        for (auto algorithm : {LabellingAlgorithm::PIXELS, LabellingAlgorithm::BLOCKS}){
+            auto result = findSegments(map, algorithm);
+            REQUIRE(expected.size() == result.size());
+            REQUIRE(segmentsAsSets(expected) == segmentsAsSets(result));
+        }
+    }
+}
+
+TEST_CASE("Tests for 8-connectivity", "[segmentation][connectivity]"){
+    SECTION("diagonal pixels are connected"){
+        PixelsMap legacy = {
+            {true,  true,  false, false, true},
+            {false, true,  false, true,  true},
+            {true,  false, false, false, false},
+            {true,  false, true,  false, true},
+            {true,  true,  true,  false, true}
+        };
+
+        auto segments = findSegments<8>(legacy);
+        REQUIRE(segments.size() == 3);
+        REQUIRE(segments[0].pixels.size() == 9);
+        REQUIRE(segments[1].pixels.size() == 3);
+        REQUIRE(segments[2].pixels.size() == 2);
+        REQUIRE(findSegmentStats<8>(legacy).size() == 3);
+        REQUIRE(findRunSegments<8>(legacy).size() == 3);
+        REQUIRE(findSegments<4>(legacy).size() == 4);
+    }
+
+    SECTION("all labellers give the same segments as flood fill for random maps"){
+        srand(45);
+
+        for (auto size : std::vector<std::pair<int, int>>({{1, 70}, {2, 3}, {57, 131}, {101, 65}, {150, 128}})){
+            for (int density = 1; density < 10; density += 2){
+                PackedPixelsMap map = randomPixelsMap(size.first, size.second, density);
+
+                auto expected = findSegmentsFloodFill<8>(map);
+                auto result = findSegments<8>(map);
+                REQUIRE(expected.size() == result.size());
+                REQUIRE(segmentsAsSets(expected) == segmentsAsSets(result));
+
+                LabelImage labels = labelComponents<8>(map);
+                REQUIRE(labelComponentsBlocks<8>(map).labels == labels.labels);
+
+                auto runs = findRunSegments<8>(map);
+                auto stats = labelStats<8>(map);
+                REQUIRE(runs.size() == labels.count);
+                REQUIRE(stats.size() == labels.count);
+                int differences = 0;
+                for (size_t i = 0; i < runs.size(); ++i){
+                    differences += runs[i].size() != expected[i].pixels.size() || stats[i].count != expected[i].pixels.size();
+                }
+                REQUIRE(differences == 0);
+
+                ThreadsNumberGuard guard(3);
+                REQUIRE(labelComponentsParallel<8>(map).labels == labels.labels);
+                requireSameStats(stats, labelStatsParallel<8>(map));
+            }
+        }
+    }
+
+    SECTION("wrong connectivity"){
+        REQUIRE_THROWS(checkConnectivity(6));
+        REQUIRE_NOTHROW(checkConnectivity(8));
+    }
+}
+
+TEST_CASE("Tests for findClassSegments function", "[segmentation][findClassSegments]"){
+    PackedPixelsMap first(4, 6), second(4, 6);
+    first.set(0, 0, true);
+    first.set(0, 1, true);
+    first.set(3, 5, true);
+    second.set(0, 1, true);
+    second.set(1, 1, true);
+
+    auto segments = findClassSegments({first, second, PackedPixelsMap(4, 6)});
+    REQUIRE(segments.size() == 3);
+    REQUIRE(segments[0].classId == 0);
+    REQUIRE(segments[0].segment.id == 1);
+    REQUIRE(segments[0].segment.size() == 2);
+    REQUIRE(segments[1].classId == 0);
+    REQUIRE(segments[1].segment.id == 2);
+    REQUIRE(segments[2].classId == 1);
+    REQUIRE(segments[2].segment.id == 1);
+    // pixel of both classes is in segments of both of them
+    REQUIRE(segments[2].segment.size() == 2);
+}
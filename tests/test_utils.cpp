@@ -8,6 +8,7 @@
 #include<vector>
 #include<cmath>
 #include<limits>
+#include<utility>
 
 // opencv
 #include <opencv2/opencv.hpp>
@@ -31,3 +32,345 @@ TEST_CASE("Tests for rankFilter function", "[utils][rankFilter]"){
         REQUIRE(m(2, 2) == expected);
     }
 }
+
+TEST_CASE("Tests for rankFilterHistogram function", "[utils][rankFilter]"){
+    SECTION("same result as sort based filter for random image with many equal pixels"){
+        srand(7);
+
+        cv::Mat img(40, 50, CV_8UC3);
+        cv::Mat_<cv::Vec3b> m = img;
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                uint8_t b = (rand()%4) * 60;
+                uint8_t g = (rand()%4) * 60;
+                uint8_t r = (rand()%4) * 60;
+                m(row, col) = {b, g, r};
+            }
+        }
+
+        std::vector<std::vector<int>> configs = {
+            {DEFUALT_RANK_FILTER_WIDTH, DEFUALT_RANK_FILTER_HEIGHT, DEFAULT_RANK_FILTER_RANK},
+            {3, 3, 4},
+            {7, 3, 20},
+            {1, 9, 0},
+            {5, 5, 24}
+        };
+
+        for (auto& c : configs){
+            cv::Mat expected = rankFilterSort(img, c[0], c[1], c[2]);
+            cv::Mat result = rankFilterHistogram(img, c[0], c[1], c[2]);
+            cv::Mat_<cv::Vec3b> e = expected;
+            cv::Mat_<cv::Vec3b> k = result;
+
+            for ( int row =0; row<img.rows; ++row){
+                for(int col = 0; col<img.cols; ++col){
+                    REQUIRE(e(row, col) == k(row, col));
+                }
+            }
+        }
+    }
+
+    SECTION("wrong arguments"){
+        cv::Mat img(10, 10, CV_8UC3);
+        REQUIRE_THROWS(rankFilterHistogram(img, 4, 5, 1));
+        REQUIRE_THROWS(rankFilterHistogram(img, 3, 3, 9));
+    }
+}
+
+TEST_CASE("Tests for rankFilterNetwork function", "[utils][rankFilter]"){
+    SECTION("same result as sort based filter for 3x3, 5x5 and 7x7 windows"){
+        srand(11);
+
+        cv::Mat img(30, 35, CV_8UC3);
+        cv::Mat_<cv::Vec3b> m = img;
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                uint8_t b = (rand()%3) * 100;
+                uint8_t g = (rand()%3) * 100;
+                uint8_t r = rand()%256;
+                m(row, col) = {b, g, r};
+            }
+        }
+
+        for (int size = 3; size <= 7; size += 2){
+            for (unsigned int rank = 0; rank < static_cast<unsigned int>(size * size); rank += 4){
+                cv::Mat expected = rankFilterSort(img, size, size, rank);
+                cv::Mat result = rankFilter(img, size, size, rank);
+                cv::Mat_<cv::Vec3b> e = expected;
+                cv::Mat_<cv::Vec3b> k = result;
+
+                for ( int row =0; row<img.rows; ++row){
+                    for(int col = 0; col<img.cols; ++col){
+                        REQUIRE(e(row, col) == k(row, col));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Tests for rankFilterSimd function", "[utils][rankFilter][data]"){
+    std::vector<SimdLevel> levels = {SimdLevel::SCALAR};
+    if (detectSimdLevel() != SimdLevel::SCALAR){
+        levels.emplace_back(SimdLevel::SSE41);
+    }
+    if (detectSimdLevel() == SimdLevel::AVX2){
+        levels.emplace_back(SimdLevel::AVX2);
+    }
+
+    SECTION("same result as rankFilter for all images from data directory"){
+        for (auto& name : TEST_FILES_NAMES){
+            cv::Mat img = cv::imread(std::string(LEGO_DATA_DIR) + name);
+            REQUIRE(!img.empty());
+
+            cv::Mat expected = rankFilterSort(img, DEFUALT_RANK_FILTER_WIDTH,
+                                              DEFUALT_RANK_FILTER_HEIGHT,
+                                              DEFAULT_RANK_FILTER_RANK);
+            cv::Mat_<cv::Vec3b> e = expected;
+
+            for (auto level : levels){
+                cv::Mat result = rankFilterSimd<DEFUALT_RANK_FILTER_WIDTH>(img, DEFAULT_RANK_FILTER_RANK, level);
+                cv::Mat_<cv::Vec3b> k = result;
+
+                int different = 0;
+                for ( int row =0; row<img.rows; ++row){
+                    for(int col = 0; col<img.cols; ++col){
+                        if (e(row, col) != k(row, col)){
+                            ++different;
+                        }
+                    }
+                }
+                REQUIRE(different == 0);
+            }
+        }
+    }
+
+    SECTION("same result as rankFilter for 3x3 and 7x7 windows and row ends"){
+        srand(13);
+
+        cv::Mat img(21, 45, CV_8UC3);
+        cv::Mat_<cv::Vec3b> m = img;
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                uint8_t c = (rand()%5) * 50;
+                m(row, col) = {c, static_cast<uint8_t>(rand()%256), c};
+            }
+        }
+
+        for (auto level : levels){
+            for (unsigned int rank = 0; rank < 9; ++rank){
+                cv::Mat_<cv::Vec3b> e = rankFilterSort(img, 3, 3, rank);
+                cv::Mat_<cv::Vec3b> k = rankFilterSimd<3>(img, rank, level);
+                for ( int row =0; row<img.rows; ++row){
+                    for(int col = 0; col<img.cols; ++col){
+                        REQUIRE(e(row, col) == k(row, col));
+                    }
+                }
+            }
+            for (unsigned int rank = 0; rank < 49; rank += 6){
+                cv::Mat_<cv::Vec3b> e = rankFilterSort(img, 7, 7, rank);
+                cv::Mat_<cv::Vec3b> k = rankFilterSimd<7>(img, rank, level);
+                for ( int row =0; row<img.rows; ++row){
+                    for(int col = 0; col<img.cols; ++col){
+                        REQUIRE(e(row, col) == k(row, col));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Tests for parallel row bands", "[utils][parallel]"){
+    SECTION("bands cover all rows and respect halo"){
+        auto bands = splitRowBands(2, 103, 4);
+        REQUIRE(bands.size() == 4);
+        REQUIRE(bands.front().begin == 2);
+        REQUIRE(bands.back().end == 103);
+        for (size_t i = 1; i < bands.size(); ++i){
+            REQUIRE(bands[i].begin == bands[i - 1].end);
+        }
+
+        bands = splitRowBands(0, 100, 16, 15);
+        REQUIRE(bands.size() == 1);
+        REQUIRE(splitRowBands(5, 5, 4).empty());
+    }
+
+    SECTION("same result for one and many threads"){
+        srand(17);
+
+        cv::Mat img(97, 61, CV_8UC3);
+        cv::Mat_<cv::Vec3b> m = img;
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                m(row, col) = {static_cast<uint8_t>(rand()%256), static_cast<uint8_t>(rand()%256), static_cast<uint8_t>(rand()%256)};
+            }
+        }
+
+        // previous number of threads is restored at the end of section
+        ThreadsNumberGuard guard(1);
+        cv::Mat_<cv::Vec3b> rankSingle = rankFilterHistogram(img, 5, 3, 7);
+        PixelsMap pixelsSingle = neighbourAwarePixelPicker(img, HSVPixelPicker(0, 255, 0, 128, 0, 255), 7, 7, 0.5f);
+
+        setThreadsNumber(4);
+        REQUIRE(getThreadsNumber() == 4);
+        cv::Mat_<cv::Vec3b> rankMulti = rankFilterHistogram(img, 5, 3, 7);
+        PixelsMap pixelsMulti = neighbourAwarePixelPicker(img, HSVPixelPicker(0, 255, 0, 128, 0, 255), 7, 7, 0.5f);
+
+        REQUIRE(pixelsSingle == pixelsMulti);
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                REQUIRE(rankSingle(row, col) == rankMulti(row, col));
+            }
+        }
+    }
+
+    SECTION("guard restores number of threads"){
+        unsigned int previous = getThreadsNumber();
+        try {
+            ThreadsNumberGuard guard(3);
+            REQUIRE(getThreadsNumber() == 3);
+            throw std::runtime_error("scope left by exception");
+        } catch (const std::runtime_error&) {
+        }
+        REQUIRE(getThreadsNumber() == previous);
+    }
+}
+
+TEST_CASE("Tests for neighbourAwarePixelPicker function", "[utils][neighbourAwarePixelPicker]"){
+    SECTION("same result as brute force version"){
+        srand(19);
+
+        cv::Mat img(60, 70, CV_32FC3);
+        cv::Mat_<cv::Vec3f> m = img;
+        for ( int row =0; row<img.rows; ++row){
+            for(int col = 0; col<img.cols; ++col){
+                // values close to FILTER_GIMP ranges borders, also fractional ones
+                float h = 10.0f + (rand()%70) * 0.5f;
+                float s = 35.0f + (rand()%140) * 0.5f;
+                float v = 15.0f + (rand()%160) * 0.5f;
+                m(row, col) = {h, s, v};
+            }
+        }
+
+        std::vector<std::vector<int>> windows = {
+            {DEFUALT_PIX_CHOOSE_WIDTH, DEFUALT_PIX_CHOOSE_HEIGHT},
+            {3, 3},
+            {7, 1},
+            {1, 1},
+            {81, 5}
+        };
+
+        for (auto& w : windows){
+            for (float percent : {0.0f, 0.2f, DEFUALT_PIX_CHOOSE_PERCENT}){
+                PixelsMap expected = neighbourAwarePixelPickerBruteForce(img, FILTER_GIMP, w[0], w[1], percent);
+                PixelsMap result = neighbourAwarePixelPicker(img, FILTER_GIMP, w[0], w[1], percent);
+                REQUIRE(expected == result);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The ScalarHSVPixelPicker class - picker that uses default classifyRow of PixelPicker.
+ */
+class ScalarHSVPixelPicker : public PixelPicker{
+private:
+    HSVPixelPicker picker;
+
+public:
+    ScalarHSVPixelPicker(const HSVPixelPicker& picker) : picker(picker) {}
+
+    bool isCorrectPixel(float h, float s, float v) const {
+        return picker.isCorrectPixel(h, s, v);
+    }
+};
+
+TEST_CASE("Tests for classifyRow function", "[utils][classifyRow]"){
+    srand(43);
+
+    for (size_t n : {1u, 7u, 8u, 63u, 64u, 65u, 200u, 1000u}){
+        std::vector<float> hsv(3 * n);
+        for (auto& value : hsv){
+            // integer values hit ranges borders
+            value = rand()%3 == 0 ? static_cast<float>(rand()%101) : static_cast<float>(rand()) / RAND_MAX * 110.0f;
+        }
+        hsv[0] = std::numeric_limits<float>::quiet_NaN();
+
+        ScalarHSVPixelPicker scalar(FILTER_GIMP);
+        const size_t words = (n + 63) / 64;
+        std::vector<uint64_t> expected(words, ~uint64_t(0)), result(words, ~uint64_t(0));
+        scalar.classifyRow(hsv.data(), n, expected.data());
+        FILTER_GIMP.classifyRow(hsv.data(), n, result.data());
+
+        REQUIRE(expected == result);
+        for (size_t j = 0; j < n; ++j){
+            bool bit = (result[j / 64] >> (j % 64)) & 1u;
+            REQUIRE(bit == FILTER_GIMP.isCorrectPixel(hsv[3 * j], hsv[3 * j + 1], hsv[3 * j + 2]));
+        }
+        // bits after last color are 0
+        if (n % 64 != 0){
+            REQUIRE((result.back() >> (n % 64)) == 0);
+        }
+    }
+}
+
+TEST_CASE("Tests for MultiClassPixelPicker", "[utils][MultiClassPixelPicker]"){
+    std::vector<HSVPixelPicker> classes = {
+        FILTER_GIMP,
+        HSVPixelPicker(0, 10, 50, 100, 20, 90),
+        HSVPixelPicker(200, 250, 40, 100, 20, 90),
+        HSVPixelPicker(0, 255, 0, 30, 0, 100)
+    };
+    MultiClassPixelPicker picker(classes);
+
+    SECTION("class masks are the same as single class pickers"){
+        srand(47);
+        std::vector<float> hsv(3 * 501);
+        for (auto& value : hsv){
+            value = static_cast<float>(rand()%256);
+        }
+
+        std::vector<uint16_t> masks(501);
+        std::vector<uint64_t> bits(8), classBits(8);
+        picker.classifyRowClasses(hsv.data(), 501, masks.data(), classBits.data());
+        picker.classifyRow(hsv.data(), 501, bits.data());
+
+        for (size_t j = 0; j < 501; ++j){
+            uint16_t expected = 0;
+            for (size_t c = 0; c < classes.size(); ++c){
+                if (classes[c].isCorrectPixel(hsv[3 * j], hsv[3 * j + 1], hsv[3 * j + 2])){
+                    expected |= static_cast<uint16_t>(1u << c);
+                }
+            }
+            REQUIRE(masks[j] == expected);
+            REQUIRE(picker.classMask(hsv[3 * j], hsv[3 * j + 1], hsv[3 * j + 2]) == expected);
+            REQUIRE(static_cast<bool>((bits[j / 64] >> (j % 64)) & 1u) == (expected != 0));
+        }
+    }
+
+    SECTION("each class is picked the same as by single class picker"){
+        cv::Mat img = cvtImgColorsToGIMPHSV(cv::imread(std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[0]));
+        auto result = neighbourAwareMultiClassPicker(img, picker, 15, 15, 0.5f);
+
+        REQUIRE(result.size() == classes.size());
+        for (size_t c = 0; c < classes.size(); ++c){
+            REQUIRE(result[c] == neighbourAwarePixelPicker(img, classes[c], 15, 15, 0.5f));
+        }
+    }
+
+    SECTION("windows of classes are counted the same for not square windows"){
+        cv::Mat img = cvtImgColorsToGIMPHSV(cv::imread(std::string(LEGO_DATA_DIR) + TEST_FILES_NAMES[1]));
+        for (auto window : {std::make_pair(1, 1), std::make_pair(3, 9), std::make_pair(21, 5)}){
+            auto result = neighbourAwareMultiClassPicker(img, picker, window.first, window.second, 0.3f);
+            for (size_t c = 0; c < classes.size(); ++c){
+                REQUIRE(result[c] == neighbourAwarePixelPicker(img, classes[c], window.first, window.second, 0.3f));
+            }
+        }
+    }
+
+    SECTION("wrong number of classes"){
+        REQUIRE_THROWS(MultiClassPixelPicker(std::vector<HSVPixelPicker>()));
+        REQUIRE_THROWS(MultiClassPixelPicker(std::vector<HSVPixelPicker>(MultiClassPixelPicker::MAX_CLASSES + 1, FILTER_GIMP)));
+        REQUIRE_NOTHROW(MultiClassPixelPicker(std::vector<HSVPixelPicker>(MultiClassPixelPicker::MAX_CLASSES, FILTER_GIMP)));
+    }
+}